@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __APPLE__
+#include <sys/sysctl.h>
+#endif
+#include "autotune.h"
+
+#define AT_LINE_MAX 1024
+
+const char *at_cpu_model(void) {
+    static char model[256] = "";
+    if (model[0]) return model;
+#if defined(__APPLE__)
+    size_t len = sizeof(model);
+    if (sysctlbyname("machdep.cpu.brand_string", model, &len, NULL, 0) != 0) model[0] = '\0';
+#elif defined(__linux__)
+    FILE *fp = fopen("/proc/cpuinfo", "r");
+    if (fp) {
+        char line[AT_LINE_MAX];
+        while (fgets(line, sizeof(line), fp)) {
+            // x86 为 "model name"，部分 ARM 内核只有 "Hardware" / "CPU part"
+            if (strncmp(line, "model name", 10) == 0 || strncmp(line, "Hardware", 8) == 0) {
+                char *colon = strchr(line, ':');
+                if (colon) {
+                    colon++;
+                    while (*colon == ' ' || *colon == '\t') colon++;
+                    snprintf(model, sizeof(model), "%s", colon);
+                    break;
+                }
+            }
+        }
+        fclose(fp);
+    }
+#endif
+    if (!model[0]) snprintf(model, sizeof(model), "unknown");
+    // 去掉换行，分隔符 ';' 替换为空格
+    for (char *p = model; *p; ++p) {
+        if (*p == '\n' || *p == '\r') { *p = '\0'; break; }
+        if (*p == ';') *p = ' ';
+    }
+    return model;
+}
+
+static const char *at_cache_path(void) {
+    const char *p = getenv("AUTOTUNE_CACHE");
+    return (p && *p) ? p : "autotune.cache";
+}
+
+// 判断一行是否是 (cpu, kernel, size) 的记录，是则返回参数部分的起始位置
+static char *at_match(char *line, const char *kernel, long long size) {
+    const char *cpu = at_cpu_model();
+    size_t lc = strlen(cpu), lk = strlen(kernel);
+    if (strncmp(line, cpu, lc) != 0 || line[lc] != ';') return NULL;
+    char *p = line + lc + 1;
+    if (strncmp(p, kernel, lk) != 0 || p[lk] != ';') return NULL;
+    p += lk + 1;
+    char *end;
+    long long s = strtoll(p, &end, 10);
+    if (end == p || *end != ';' || s != size) return NULL;
+    return end + 1;
+}
+
+int at_load(const char *kernel, long long size, const at_param_t *params, int nparams, at_config_t *cfg) {
+    FILE *fp = fopen(at_cache_path(), "r");
+    if (!fp) return -1;
+    char line[AT_LINE_MAX];
+    int found = -1;
+    while (found != 0 && fgets(line, sizeof(line), fp)) {
+        char *p = at_match(line, kernel, size);
+        if (!p) continue;
+        // 每个参数都必须出现在记录中，否则视为过期记录
+        int seen = 0;
+        for (int i = 0; i < nparams; ++i) {
+            size_t ln = strlen(params[i].name);
+            for (char *q = p; *q && *q != ';'; ) {
+                if (strncmp(q, params[i].name, ln) == 0 && q[ln] == '=') {
+                    cfg->v[i] = atoi(q + ln + 1);
+                    seen++;
+                    break;
+                }
+                q = strpbrk(q, ",;");
+                if (!q || *q == ';') break;
+                q++;
+            }
+        }
+        if (seen == nparams) found = 0;
+    }
+    fclose(fp);
+    return found;
+}
+
+int at_store(const char *kernel, long long size, const at_param_t *params, int nparams,
+             const at_config_t *cfg, double seconds) {
+    const char *path = at_cache_path();
+    char tmp[AT_LINE_MAX];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *out = fopen(tmp, "w");
+    if (!out) return -1;
+    // 保留其他记录，替换同键的旧记录
+    FILE *in = fopen(path, "r");
+    if (in) {
+        char line[AT_LINE_MAX];
+        while (fgets(line, sizeof(line), in)) {
+            if (!at_match(line, kernel, size)) fputs(line, out);
+        }
+        fclose(in);
+    }
+    fprintf(out, "%s;%s;%lld;", at_cpu_model(), kernel, size);
+    for (int i = 0; i < nparams; ++i)
+        fprintf(out, "%s%s=%d", i ? "," : "", params[i].name, cfg->v[i]);
+    fprintf(out, ";%.6g\n", seconds);
+    if (fclose(out) != 0) return -1;
+    return rename(tmp, path) == 0 ? 0 : -1;
+}
+
+static double at_measure_best(at_measure_fn measure, void *ctx, const at_config_t *cfg) {
+    double best = measure(cfg, ctx);
+    for (int r = 1; r < AT_REPEATS; ++r) {
+        double t = measure(cfg, ctx);
+        if (t < best) best = t;
+    }
+    return best;
+}
+
+double at_search(const at_param_t *params, int nparams, at_measure_fn measure, void *ctx, at_config_t *best) {
+    at_config_t cur;
+    memset(&cur, 0, sizeof(cur));
+    for (int i = 0; i < nparams; ++i) cur.v[i] = params[i].values[0];
+    double best_time = at_measure_best(measure, ctx, &cur);
+
+    for (int pass = 0; pass < AT_MAX_PASSES; ++pass) {
+        int improved = 0;
+        for (int i = 0; i < nparams; ++i) {
+            for (int c = 0; c < params[i].count; ++c) {
+                if (params[i].values[c] == cur.v[i]) continue;
+                at_config_t trial = cur;
+                trial.v[i] = params[i].values[c];
+                double t = at_measure_best(measure, ctx, &trial);
+                if (t < best_time) {
+                    best_time = t;
+                    cur = trial;
+                    improved = 1;
+                }
+            }
+        }
+        if (!improved) break;
+    }
+    *best = cur;
+    return best_time;
+}
+
+int at_tune(const char *kernel, long long size, const at_param_t *params, int nparams,
+            at_measure_fn measure, void *ctx, at_config_t *best) {
+    const char *mode = getenv("AUTOTUNE");
+    int force = mode && strcmp(mode, "force") == 0;
+    int off = mode && strcmp(mode, "off") == 0;
+    if (!force && at_load(kernel, size, params, nparams, best) == 0) return 1;
+    if (off) {
+        memset(best, 0, sizeof(*best));
+        for (int i = 0; i < nparams; ++i) best->v[i] = params[i].values[0];
+        return -1;
+    }
+    double t = at_search(params, nparams, measure, ctx, best);
+    at_store(kernel, size, params, nparams, best, t);
+    return 0;
+}
@@ -0,0 +1,57 @@
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+/*
+ * 文件：autotune.h
+ * 功能：在当前机器上为给定问题规模搜索块大小、分块形状、线程数、调度方式等参数，
+ *       并把最优配置写入缓存文件，下次启动时直接读取。
+ *
+ * 参数空间由调用者给出：每个参数有名字和若干候选值，配置 at_config_t 的 v[i] 对应第 i 个参数。
+ * 搜索采用坐标下降：依次对每个参数遍历候选值（其余参数固定为当前最优），
+ * 直到一整轮没有改进（最多 AT_MAX_PASSES 轮），代价是各参数候选数之和而不是乘积。
+ * 每个配置测量 AT_REPEATS 次取最小值。
+ *
+ * 缓存文件默认为当前目录下的 autotune.cache，可用环境变量 AUTOTUNE_CACHE 指定路径。
+ * 每行一条记录，键为 (CPU 型号, 内核名, 规模)：
+ *     CPU 型号;内核名;规模;参数名=值,参数名=值,...;最优耗时(秒)
+ * 环境变量 AUTOTUNE=force 忽略缓存重新搜索，AUTOTUNE=off 不搜索（只读缓存，没有则用各参数的第一个候选值）。
+ */
+
+#define AT_MAX_PARAMS 8
+#define AT_MAX_PASSES 2
+#define AT_REPEATS 3
+
+typedef struct {
+    int v[AT_MAX_PARAMS];
+} at_config_t;
+
+typedef struct {
+    const char *name;
+    const int *values;
+    int count;
+} at_param_t;
+
+// 用配置 cfg 运行一次被调优的内核，返回耗时（秒）
+typedef double (*at_measure_fn)(const at_config_t *cfg, void *ctx);
+
+// CPU 型号字符串（Linux 读 /proc/cpuinfo，macOS 读 machdep.cpu.brand_string）
+const char *at_cpu_model(void);
+
+// 从缓存读取配置，找到返回 0
+int at_load(const char *kernel, long long size, const at_param_t *params, int nparams, at_config_t *cfg);
+
+// 写入（或替换）缓存中的记录，成功返回 0
+int at_store(const char *kernel, long long size, const at_param_t *params, int nparams,
+             const at_config_t *cfg, double seconds);
+
+// 坐标下降搜索，返回最优配置的耗时
+double at_search(const at_param_t *params, int nparams, at_measure_fn measure, void *ctx, at_config_t *best);
+
+/*
+ * 先查缓存，没有（或 AUTOTUNE=force）则搜索并写入缓存。
+ * 返回 1 表示来自缓存，0 表示本次搜索得到，-1 表示未调优（AUTOTUNE=off 且无缓存，best 为默认值）。
+ */
+int at_tune(const char *kernel, long long size, const at_param_t *params, int nparams,
+            at_measure_fn measure, void *ctx, at_config_t *best);
+
+#endif
@@ -0,0 +1,108 @@
+#include "cache_oblivious.h"
+
+// 递归终止规模：只为摊薄函数调用开销与保持最内层循环足够长，不针对任何缓存大小
+#define CO_MATMUL_LEAF 262144    // m * n * k 不超过 64^3 时用基础核
+#define CO_ROW_BIAS 4            // 连续维 k 至少是其他维的 4 倍才切它，使基础核的行保持足够长
+#define CO_TRANSPOSE_LEAF 256    // rows * cols 不超过 16 x 16 时直接转置
+
+// 基础核：i-k-j 顺序，最内层对 B、C 的一行连续访问，可被编译器向量化
+static void matmul_leaf(int m, int n, int k,
+                        const double *restrict A, size_t lda,
+                        const double *restrict B, size_t ldb,
+                        double *restrict C, size_t ldc) {
+    for (int i = 0; i < m; i++) {
+        double *c = C + (size_t)i * ldc;
+        const double *a = A + (size_t)i * lda;
+        for (int l = 0; l < n; l++) {
+            double ail = a[l];
+            const double *b = B + (size_t)l * ldb;
+            for (int j = 0; j < k; j++) c[j] += ail * b[j];
+        }
+    }
+}
+
+void co_matmul(int m, int n, int k,
+               const double *A, size_t lda,
+               const double *B, size_t ldb,
+               double *C, size_t ldc) {
+    if (m <= 0 || n <= 0 || k <= 0) return;
+    if ((long long)m * n * k <= CO_MATMUL_LEAF) {
+        matmul_leaf(m, n, k, A, lda, B, ldb, C, ldc);
+        return;
+    }
+    if (m >= n && CO_ROW_BIAS * m >= k) {
+        // 切 A、C 的行
+        int h = m / 2;
+        co_matmul(h, n, k, A, lda, B, ldb, C, ldc);
+        co_matmul(m - h, n, k, A + (size_t)h * lda, lda, B, ldb, C + (size_t)h * ldc, ldc);
+    } else if (k >= CO_ROW_BIAS * n) {
+        // 切 B、C 的列
+        int h = k / 2;
+        co_matmul(m, n, h, A, lda, B, ldb, C, ldc);
+        co_matmul(m, n, k - h, A, lda, B + h, ldb, C + h, ldc);
+    } else {
+        // 切公共维：两半依次累加到同一个 C
+        int h = n / 2;
+        co_matmul(m, h, k, A, lda, B, ldb, C, ldc);
+        co_matmul(m, n - h, k, A + h, lda, B + (size_t)h * ldb, ldb, C, ldc);
+    }
+}
+
+void co_transpose(int rows, int cols, const double *A, size_t lda, double *B, size_t ldb) {
+    if (rows <= 0 || cols <= 0) return;
+    if ((long long)rows * cols <= CO_TRANSPOSE_LEAF) {
+        for (int i = 0; i < rows; i++)
+            for (int j = 0; j < cols; j++)
+                B[(size_t)j * ldb + i] = A[(size_t)i * lda + j];
+        return;
+    }
+    if (rows >= cols) {
+        int h = rows / 2;
+        co_transpose(h, cols, A, lda, B, ldb);
+        co_transpose(rows - h, cols, A + (size_t)h * lda, lda, B + h, ldb);
+    } else {
+        int h = cols / 2;
+        co_transpose(rows, h, A, lda, B, ldb);
+        co_transpose(rows, cols - h, A + h, lda, B + (size_t)h * ldb, ldb);
+    }
+}
+
+// 交换转置：X（rows x cols）与 Y（cols x rows）互换为对方的转置，X、Y 为同一矩阵中不重叠的两块
+static void transpose_swap(int rows, int cols, double *X, double *Y, size_t lda) {
+    if ((long long)rows * cols <= CO_TRANSPOSE_LEAF) {
+        for (int i = 0; i < rows; i++)
+            for (int j = 0; j < cols; j++) {
+                double t = X[(size_t)i * lda + j];
+                X[(size_t)i * lda + j] = Y[(size_t)j * lda + i];
+                Y[(size_t)j * lda + i] = t;
+            }
+        return;
+    }
+    if (rows >= cols) {
+        int h = rows / 2;
+        transpose_swap(h, cols, X, Y, lda);
+        transpose_swap(rows - h, cols, X + (size_t)h * lda, Y + h, lda);
+    } else {
+        int h = cols / 2;
+        transpose_swap(rows, h, X, Y, lda);
+        transpose_swap(rows, cols - h, X + h, Y + (size_t)h * lda, lda);
+    }
+}
+
+void co_transpose_inplace(int n, double *A, size_t lda) {
+    if (n <= 1) return;
+    if ((long long)n * n <= CO_TRANSPOSE_LEAF) {
+        for (int i = 0; i < n; i++)
+            for (int j = i + 1; j < n; j++) {
+                double t = A[(size_t)i * lda + j];
+                A[(size_t)i * lda + j] = A[(size_t)j * lda + i];
+                A[(size_t)j * lda + i] = t;
+            }
+        return;
+    }
+    // [A11 A12; A21 A22]：A11、A22 原地转置，A12 与 A21 交换转置
+    int h = n / 2;
+    co_transpose_inplace(h, A, lda);
+    co_transpose_inplace(n - h, A + (size_t)h * lda + h, lda);
+    transpose_swap(h, n - h, A + h, A + (size_t)h * lda, lda);
+}
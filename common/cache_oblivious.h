@@ -0,0 +1,32 @@
+#ifndef CACHE_OBLIVIOUS_H
+#define CACHE_OBLIVIOUS_H
+
+/*
+ * 文件：cache_oblivious.h
+ * 功能：缓存无关（cache-oblivious）的递归矩阵乘法与转置，均为行主序、带行跨度（leading dimension）。
+ *
+ * 每次把当前问题最大的一维对半切分，直到子问题足够小再交给简单的基础核。
+ * 递归到某一层时子矩阵恰好能放进某一级缓存，之后的计算都在该级缓存内完成，
+ * 对每一级缓存同时成立，因此不需要针对缓存大小调分块参数，
+ * 对任意（非方阵、非 2 的幂）的 m x n x k 都有接近最优的缓存缺失数。
+ * 基础核的规模只用于摊薄递归调用开销，与缓存大小无关。
+ */
+
+#include <stddef.h>
+
+/*
+ * C += A * B。A 为 m x n（行跨度 lda），B 为 n x k（ldb），C 为 m x k（ldc）。
+ * 需要 C = A * B 时先把 C 清零。
+ */
+void co_matmul(int m, int n, int k,
+               const double *A, size_t lda,
+               const double *B, size_t ldb,
+               double *C, size_t ldc);
+
+// B = A^T，A 为 rows x cols（lda），B 为 cols x rows（ldb），A 与 B 不能重叠
+void co_transpose(int rows, int cols, const double *A, size_t lda, double *B, size_t ldb);
+
+// 原地转置 n x n 方阵 A（lda）：对角块递归原地转置，非对角块递归交换转置
+void co_transpose_inplace(int n, double *A, size_t lda);
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef COUNTER_RNG_H
+#define COUNTER_RNG_H
+
+/*
+ * 文件：counter_rng.h
+ * 功能：基于计数器的随机数生成（splitmix64 混合函数）。
+ *       第 i 个随机数只由 (seed, stream, i) 决定，不依赖任何内部状态，
+ *       因此可以按任意方式把下标区间切分给线程或 MPI 进程并行填充，
+ *       对同一个种子得到的矩阵与线程数、进程数无关。
+ *
+ * 用法：key = crng_key(seed, stream)，再对全局下标 i 调用 crng_uniform(key, i)。
+ *       一般用 stream 区分同一次运行中的不同矩阵（如 A 用 0、B 用 1）。
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define CRNG_DEFAULT_SEED 20240901ULL
+
+// splitmix64 的最终混合步骤，是一个 64 位双射
+static inline uint64_t crng_mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// 由种子与流编号生成一个流的密钥
+static inline uint64_t crng_key(uint64_t seed, uint64_t stream) {
+    return crng_mix64(seed ^ crng_mix64(stream * 0xd1b54a32d192ed03ULL + 0x9e3779b97f4a7c15ULL));
+}
+
+// 第 ctr 个 64 位随机数
+static inline uint64_t crng_u64(uint64_t key, uint64_t ctr) {
+    return crng_mix64(key ^ crng_mix64(ctr * 0x9e3779b97f4a7c15ULL + 0x632be59bd9b4e019ULL));
+}
+
+// 第 ctr 个 [0,1) 区间的双精度随机数（53 位精度）
+static inline double crng_uniform(uint64_t key, uint64_t ctr) {
+    return (double)(crng_u64(key, ctr) >> 11) * 0x1.0p-53;
+}
+
+// 第 ctr 个 [0, bound) 区间的随机整数（乘法取高位，避免取模偏差过大）
+static inline uint32_t crng_below(uint64_t key, uint64_t ctr, uint32_t bound) {
+    return (uint32_t)(((crng_u64(key, ctr) >> 32) * (uint64_t)bound) >> 32);
+}
+
+/*
+ * 填充全局下标区间 [begin, end) 对应的元素，dst 指向下标 begin 处。
+ * 值为 lo + (hi - lo) * U[0,1)。调用者负责把区间划分给各线程/进程。
+ */
+static inline void crng_fill_uniform(double *dst, long long begin, long long end,
+                                     uint64_t key, double lo, double hi) {
+    const double scale = hi - lo;
+    for (long long i = begin; i < end; ++i)
+        dst[i - begin] = lo + scale * crng_uniform(key, (uint64_t)i);
+}
+
+// 与 crng_fill_uniform 相同，但生成 [0, bound) 的整数并以 double 存储（替代 rand() % bound）
+static inline void crng_fill_below(double *dst, long long begin, long long end,
+                                   uint64_t key, uint32_t bound) {
+    for (long long i = begin; i < end; ++i)
+        dst[i - begin] = (double)crng_below(key, (uint64_t)i, bound);
+}
+
+// 单精度版本，供 float 矩阵使用
+static inline void crng_fill_uniform_f(float *dst, long long begin, long long end,
+                                       uint64_t key, float lo, float hi) {
+    const float scale = hi - lo;
+    for (long long i = begin; i < end; ++i)
+        dst[i - begin] = lo + scale * (float)crng_uniform(key, (uint64_t)i);
+}
+
+// 从环境变量 RNG_SEED 读取种子，未设置时返回 fallback
+static inline uint64_t crng_seed_from_env(uint64_t fallback) {
+    const char *s = getenv("RNG_SEED");
+    return (s && *s) ? strtoull(s, NULL, 0) : fallback;
+}
+
+#endif
@@ -0,0 +1,85 @@
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+#include "freivalds.h"
+#include "counter_rng.h"
+
+#define FV_STREAM 0x46524556ULL    // 随机向量使用的计数器随机数流编号
+#define FV_TOL 16.0                // 舍入误差上界的安全系数
+
+int fv_trials_for(double max_false_positive) {
+    if (!(max_false_positive > 0.0) || max_false_positive >= 1.0) return 1;
+    int t = (int)ceil(-log2(max_false_positive));
+    if (t < 1) t = 1;
+    return t > FV_MAX_TRIALS ? FV_MAX_TRIALS : t;
+}
+
+double fv_false_positive_from_env(void) {
+    const char *s = getenv("FV_FALSE_POSITIVE");
+    if (s && *s) {
+        double p = strtod(s, NULL);
+        if (p > 0.0 && p < 1.0) return p;
+    }
+    return FV_DEFAULT_FALSE_POSITIVE;
+}
+
+/*
+ * 所有向量一起处理，A、B、C 各只扫描一遍：
+ *   R[j][t]   = ±1，第 t 个随机向量的第 j 个分量
+ *   BR[p][t]  = (B r_t)_p，BA[p] = (|B| 1)_p
+ *   每行 i：AR = A (B r_t)，CR = C r_t，上界用 |A| (|B| 1) 与 |C| 1
+ */
+#define FV_DEFINE_CHECK(SUFFIX, T, EPS)                                          \
+double fv_check_rows_##SUFFIX(const T *A, const T *B, const T *C,               \
+                              int rows, int n, int k, int trials, uint64_t seed) \
+{                                                                               \
+    if (trials < 1) trials = 1;                                                 \
+    if (trials > FV_MAX_TRIALS) trials = FV_MAX_TRIALS;                         \
+    const int nt = trials;                                                      \
+    double *R  = malloc(sizeof(double) * (size_t)k * nt);                       \
+    double *BR = calloc((size_t)n * nt, sizeof(double));                        \
+    double *BA = calloc((size_t)n, sizeof(double));                             \
+    if (!R || !BR || !BA) { free(R); free(BR); free(BA); return -1.0; }         \
+    uint64_t key = crng_key(seed, FV_STREAM);                                   \
+    for (int j = 0; j < k; ++j)                                                 \
+        for (int t = 0; t < nt; ++t)                                            \
+            R[(size_t)j * nt + t] =                                             \
+                (crng_u64(key, (uint64_t)t * (uint64_t)k + (uint64_t)j) >> 63) ? 1.0 : -1.0; \
+    for (int p = 0; p < n; ++p) {                                               \
+        const T *b = B + (size_t)p * k;                                         \
+        double *br = BR + (size_t)p * nt, ba = 0.0;                             \
+        for (int j = 0; j < k; ++j) {                                           \
+            const double v = b[j], *r = R + (size_t)j * nt;                     \
+            for (int t = 0; t < nt; ++t) br[t] += v * r[t];                     \
+            ba += fabs(v);                                                      \
+        }                                                                       \
+        BA[p] = ba;                                                             \
+    }                                                                           \
+    const double gamma = FV_TOL * (EPS) * sqrt(((double)n + k) / (double)k);    \
+    double worst = 0.0, ar[FV_MAX_TRIALS], cr[FV_MAX_TRIALS];                   \
+    for (int i = 0; i < rows; ++i) {                                            \
+        const T *a = A + (size_t)i * n, *c = C + (size_t)i * k;                 \
+        double abound = 0.0, cbound = 0.0;                                      \
+        for (int t = 0; t < nt; ++t) ar[t] = cr[t] = 0.0;                       \
+        for (int p = 0; p < n; ++p) {                                           \
+            const double v = a[p], *br = BR + (size_t)p * nt;                   \
+            for (int t = 0; t < nt; ++t) ar[t] += v * br[t];                    \
+            abound += fabs(v) * BA[p];                                          \
+        }                                                                       \
+        for (int j = 0; j < k; ++j) {                                           \
+            const double v = c[j], *r = R + (size_t)j * nt;                     \
+            for (int t = 0; t < nt; ++t) cr[t] += v * r[t];                     \
+            cbound += fabs(v);                                                  \
+        }                                                                       \
+        const double bound = gamma * (abound + cbound) + DBL_MIN;               \
+        for (int t = 0; t < nt; ++t) {                                          \
+            const double e = fabs(ar[t] - cr[t]) / bound;                       \
+            if (!(e <= worst)) worst = e;       /* NaN 也视为最差 */            \
+        }                                                                       \
+    }                                                                           \
+    free(R); free(BR); free(BA);                                                \
+    return worst;                                                               \
+}
+
+FV_DEFINE_CHECK(f64, double, DBL_EPSILON)
+FV_DEFINE_CHECK(f32, float,  FLT_EPSILON)
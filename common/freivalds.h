@@ -0,0 +1,40 @@
+#ifndef FREIVALDS_H
+#define FREIVALDS_H
+
+#include <stdint.h>
+
+/*
+ * 文件：freivalds.h
+ * 功能：用 Freivalds 随机算法校验矩阵乘法结果 C = A * B，每个随机向量只需 O(n^2) 运算，
+ *       代替重新计算一遍 O(n^3) 的参考结果。
+ *
+ * 取随机 ±1 向量 r，比较 A (B r) 与 C r：若 C != A B，单个向量通过的概率不超过 1/2，
+ * 因此 t 个独立向量把误判（错误结果被判为正确）的概率压到 2^-t 以下，t 由 fv_trials_for 给出。
+ * 浮点误差按行给出上界 gamma * (|A| (|B| |r|) + |C| |r|)。按舍入误差随机累积的模型，
+ * 长度为 n、k 的求和误差随项数的平方根增长，取 gamma = 16 eps sqrt((n + k) / k)；
+ * 最坏情况的线性上界要宽松得多，会漏掉单个元素的明显错误。
+ * 残差除以该上界得到归一化残差，不超过 1 视为通过。
+ *
+ * 分布式用法：r 只由 (seed, 向量编号) 决定，各进程对自己持有的 A、C 行（B 完整）调用
+ * fv_check_rows_*，得到的局部最大归一化残差用 MPI_Reduce(MPI_MAX) 汇总即为全局结果。
+ */
+
+#define FV_DEFAULT_FALSE_POSITIVE 1e-6
+#define FV_MAX_TRIALS 64
+
+// 误判概率不超过 max_false_positive 所需的随机向量个数（1 ~ FV_MAX_TRIALS）
+int fv_trials_for(double max_false_positive);
+
+// 环境变量 FV_FALSE_POSITIVE 指定的误判概率上界，未设置时为 FV_DEFAULT_FALSE_POSITIVE
+double fv_false_positive_from_env(void);
+
+/*
+ * A 为 rows x n、B 为 n x k、C 为 rows x k（均按行存储），用前 trials 个随机向量检查，
+ * 返回各行、各向量中最大的归一化残差（<= 1 通过），内存分配失败时返回 -1。
+ */
+double fv_check_rows_f64(const double *A, const double *B, const double *C,
+                         int rows, int n, int k, int trials, uint64_t seed);
+double fv_check_rows_f32(const float *A, const float *B, const float *C,
+                         int rows, int n, int k, int trials, uint64_t seed);
+
+#endif
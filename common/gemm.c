@@ -0,0 +1,152 @@
+#include <stdlib.h>
+#include <math.h>
+#include "gemm.h"
+#include "counter_rng.h"
+
+#define GEMM_KC 256                 // 公共维分段，使一段 op(B) 的行留在缓存中
+#define GEMM_TEST_STREAM 0x47454d4dULL
+
+/*
+ * 行主序问题：op(A)(i, l) = A[i * a_rs + l * a_cs]，op(B)(l, j) = B[l * b_rs + j * b_cs]。
+ *   op(B) 不转置：i-l-j 顺序，最内层沿 B 的一行与 C 的一行连续访问（公共维按 GEMM_KC 分段）；
+ *   op(B) 转置：  op(B) 的第 j 列是 B 的第 j 行，按点积计算，B 连续访问。
+ */
+#define GEMM_DEFINE(SUFFIX, T)                                                          \
+int gemm_##SUFFIX##_setup(gemm_##SUFFIX##_t *g, gemm_order_t order,                     \
+                          gemm_trans_t ta, gemm_trans_t tb, int M, int N, int K,        \
+                          T alpha, const T *A, size_t lda, const T *B, size_t ldb,      \
+                          T beta, T *C, size_t ldc)                                     \
+{                                                                                       \
+    if (M < 0 || N < 0 || K < 0) return -1;                                             \
+    if (order == GEMM_COL_MAJOR) {                                                      \
+        /* 列主序的 C 即行主序的 C^T = op(B)^T op(A)^T：交换 A、B 与 M、N */              \
+        const T *tp = A; A = B; B = tp;                                                 \
+        size_t tl = lda; lda = ldb; ldb = tl;                                           \
+        gemm_trans_t tt = ta; ta = tb; tb = tt;                                         \
+        int tm = M; M = N; N = tm;                                                      \
+    }                                                                                   \
+    const size_t a_cols = (ta == GEMM_NO_TRANS) ? (size_t)K : (size_t)M;                \
+    const size_t b_cols = (tb == GEMM_NO_TRANS) ? (size_t)N : (size_t)K;                \
+    if (lda < a_cols || ldb < b_cols || ldc < (size_t)N) return -1;                     \
+    g->M = M; g->N = N; g->K = K;                                                       \
+    g->ta = ta; g->tb = tb;                                                             \
+    g->alpha = alpha; g->beta = beta;                                                   \
+    g->A = A; g->B = B; g->C = C;                                                       \
+    g->lda = lda; g->ldb = ldb; g->ldc = ldc;                                           \
+    g->a_rs = (ta == GEMM_NO_TRANS) ? lda : 1;                                          \
+    g->a_cs = (ta == GEMM_NO_TRANS) ? 1 : lda;                                          \
+    g->b_rs = (tb == GEMM_NO_TRANS) ? ldb : 1;                                          \
+    g->b_cs = (tb == GEMM_NO_TRANS) ? 1 : ldb;                                          \
+    return 0;                                                                           \
+}                                                                                       \
+                                                                                        \
+void gemm_##SUFFIX##_block(const gemm_##SUFFIX##_t *g, int i0, int i1, int j0, int j1)  \
+{                                                                                       \
+    const T alpha = g->alpha, beta = g->beta;                                           \
+    for (int i = i0; i < i1; ++i) {                                                     \
+        T *restrict c = g->C + (size_t)i * g->ldc;                                      \
+        if (beta == (T)0)                                                               \
+            for (int j = j0; j < j1; ++j) c[j] = (T)0;                                  \
+        else if (beta != (T)1)                                                          \
+            for (int j = j0; j < j1; ++j) c[j] *= beta;                                 \
+    }                                                                                   \
+    if (alpha == (T)0 || g->K == 0) return;                                             \
+    if (g->tb == GEMM_NO_TRANS) {                                                       \
+        for (int l0 = 0; l0 < g->K; l0 += GEMM_KC) {                                    \
+            const int l1 = (l0 + GEMM_KC < g->K) ? l0 + GEMM_KC : g->K;                 \
+            for (int i = i0; i < i1; ++i) {                                             \
+                const T *a = g->A + (size_t)i * g->a_rs;                                \
+                T *restrict c = g->C + (size_t)i * g->ldc;                              \
+                for (int l = l0; l < l1; ++l) {                                         \
+                    const T ail = alpha * a[(size_t)l * g->a_cs];                       \
+                    const T *restrict b = g->B + (size_t)l * g->ldb;                    \
+                    for (int j = j0; j < j1; ++j) c[j] += ail * b[j];                   \
+                }                                                                       \
+            }                                                                           \
+        }                                                                               \
+    } else {                                                                            \
+        for (int i = i0; i < i1; ++i) {                                                 \
+            const T *a = g->A + (size_t)i * g->a_rs;                                    \
+            T *restrict c = g->C + (size_t)i * g->ldc;                                  \
+            for (int j = j0; j < j1; ++j) {                                             \
+                const T *restrict b = g->B + (size_t)j * g->ldb;                        \
+                T sum = (T)0;                                                           \
+                for (int l = 0; l < g->K; ++l) sum += a[(size_t)l * g->a_cs] * b[l];    \
+                c[j] += alpha * sum;                                                    \
+            }                                                                           \
+        }                                                                               \
+    }                                                                                   \
+}                                                                                       \
+                                                                                        \
+int gemm_##SUFFIX(gemm_order_t order, gemm_trans_t ta, gemm_trans_t tb,                 \
+                  int M, int N, int K, T alpha, const T *A, size_t lda,                 \
+                  const T *B, size_t ldb, T beta, T *C, size_t ldc)                     \
+{                                                                                       \
+    gemm_##SUFFIX##_t g;                                                                \
+    if (gemm_##SUFFIX##_setup(&g, order, ta, tb, M, N, K, alpha, A, lda, B, ldb,        \
+                              beta, C, ldc) != 0) return -1;                            \
+    gemm_##SUFFIX##_block(&g, 0, g.M, 0, g.N);                                          \
+    return 0;                                                                           \
+}                                                                                       \
+                                                                                        \
+double gemm_selftest_##SUFFIX(gemm_##SUFFIX##_fn fn, void *ctx)                         \
+{                                                                                       \
+    /* 非 2 的幂、M != N != K 的小规模，跨度比紧密存放多 3 */                          \
+    static const int shapes[][3] = { {37, 29, 41}, {64, 1, 17}, {5, 70, 300} };         \
+    static const double coeffs[][2] = { {1.0, 0.0}, {-0.5, 1.0}, {2.0, 0.25}, {0.0, 3.0} }; \
+    const int pad = 3;                                                                  \
+    double worst = 0.0;                                                                 \
+    uint64_t key = crng_key(CRNG_DEFAULT_SEED, GEMM_TEST_STREAM);                       \
+    for (int s = 0; s < 3; ++s) {                                                       \
+        const int M = shapes[s][0], N = shapes[s][1], K = shapes[s][2];                 \
+        const size_t dim = (size_t)(M > N ? (M > K ? M : K) : (N > K ? N : K)) + pad;   \
+        T *A = malloc(sizeof(T) * dim * dim), *B = malloc(sizeof(T) * dim * dim);       \
+        T *C = malloc(sizeof(T) * dim * dim), *R = malloc(sizeof(T) * dim * dim);       \
+        if (!A || !B || !C || !R) { free(A); free(B); free(C); free(R); return -1.0; }  \
+        for (size_t e = 0; e < dim * dim; ++e) {                                        \
+            A[e] = (T)(crng_uniform(key, 3 * e) - 0.5);                                 \
+            B[e] = (T)(crng_uniform(key, 3 * e + 1) - 0.5);                             \
+        }                                                                               \
+        for (int v = 0; v < 2 * 2 * 2 * 4; ++v) {                                       \
+            const gemm_order_t order = (v & 1) ? GEMM_COL_MAJOR : GEMM_ROW_MAJOR;       \
+            const gemm_trans_t ta = (v & 2) ? GEMM_TRANS : GEMM_NO_TRANS;               \
+            const gemm_trans_t tb = (v & 4) ? GEMM_TRANS : GEMM_NO_TRANS;               \
+            const T alpha = (T)coeffs[v >> 3][0], beta = (T)coeffs[v >> 3][1];          \
+            /* 存储的行（列）长度加上 pad 作为跨度 */                                    \
+            const int row_major = order == GEMM_ROW_MAJOR;                              \
+            const size_t lda = (size_t)((ta == GEMM_NO_TRANS) == row_major ? K : M) + pad; \
+            const size_t ldb = (size_t)((tb == GEMM_NO_TRANS) == row_major ? N : K) + pad; \
+            const size_t ldc = (size_t)(row_major ? N : M) + pad;                       \
+            for (size_t e = 0; e < dim * dim; ++e)                                      \
+                C[e] = R[e] = (T)(crng_uniform(key, 3 * e + 2) - 0.5);                  \
+            /* 参考：逐元素按定义计算 */                                               \
+            for (int i = 0; i < M; ++i)                                                 \
+                for (int j = 0; j < N; ++j) {                                           \
+                    double sum = 0.0;                                                   \
+                    for (int l = 0; l < K; ++l) {                                       \
+                        size_t ai = row_major ? ((ta == GEMM_NO_TRANS) ? i * lda + l : l * lda + i) \
+                                              : ((ta == GEMM_NO_TRANS) ? l * lda + i : i * lda + l); \
+                        size_t bi = row_major ? ((tb == GEMM_NO_TRANS) ? l * ldb + j : j * ldb + l) \
+                                              : ((tb == GEMM_NO_TRANS) ? j * ldb + l : l * ldb + j); \
+                        sum += (double)A[ai] * (double)B[bi];                           \
+                    }                                                                   \
+                    size_t ci = row_major ? i * ldc + j : j * ldc + i;                  \
+                    R[ci] = (T)(alpha * sum + (beta == (T)0 ? 0.0 : (double)beta * R[ci])); \
+                }                                                                       \
+            fn(order, ta, tb, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc, ctx);       \
+            double scale = 0.0, err = 0.0;                                              \
+            for (size_t e = 0; e < dim * dim; ++e) {                                    \
+                if (fabs((double)R[e]) > scale) scale = fabs((double)R[e]);             \
+                double d = fabs((double)C[e] - (double)R[e]);                           \
+                if (!(d <= err)) err = d;          /* NaN 也视为最差 */                 \
+            }                                                                           \
+            err /= (scale > 0.0 ? scale : 1.0);                                         \
+            if (!(err <= worst)) worst = err;                                           \
+        }                                                                               \
+        free(A); free(B); free(C); free(R);                                             \
+    }                                                                                   \
+    return worst;                                                                       \
+}
+
+GEMM_DEFINE(f64, double)
+GEMM_DEFINE(f32, float)
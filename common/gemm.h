@@ -0,0 +1,78 @@
+#ifndef GEMM_H
+#define GEMM_H
+
+#include <stddef.h>
+
+/*
+ * 文件：gemm.h
+ * 功能：各实验自研矩阵乘法核共用的完整 GEMM 语义 C = alpha * op(A) * op(B) + beta * C，
+ *       参数与 cblas_dgemm / cblas_sgemm 一致，可直接替换 BLAS 调用：
+ *         op(A) 为 M x K，op(B) 为 K x N，C 为 M x N；lda / ldb / ldc 为存储时的行（列）跨度；
+ *         支持行主序与列主序、A / B 各自转置；beta = 0 时不读取 C（C 中的 NaN 不会传播）。
+ *
+ * 用法：gemm_*_setup 检查参数并把问题统一成行主序描述（列主序时按 C^T = op(B)^T op(A)^T 交换 A、B），
+ *       并行核把 C 划分成若干块，各块调用 gemm_*_block 计算；也可以直接调用串行的 gemm_f64 / gemm_f32。
+ *       描述中的 a_rs / a_cs 为 op(A) 的行、列步长（op(A)(i, l) = A[i * a_rs + l * a_cs]），B 同理，
+ *       供逐元素或自行打包的核使用。
+ *
+ * gemm_selftest_*：用若干随机的小规模问题（行/列主序、各种转置、非紧密跨度、alpha / beta 组合）
+ * 把调用者给出的核与逐元素参考实现比较，返回最大相对误差。
+ */
+
+typedef enum { GEMM_ROW_MAJOR = 0, GEMM_COL_MAJOR = 1 } gemm_order_t;
+typedef enum { GEMM_NO_TRANS = 0, GEMM_TRANS = 1 } gemm_trans_t;
+
+// 统一成行主序后的问题描述
+typedef struct {
+    int M, N, K;
+    gemm_trans_t ta, tb;
+    double alpha, beta;
+    const double *A, *B;
+    double *C;
+    size_t lda, ldb, ldc;
+    size_t a_rs, a_cs, b_rs, b_cs;
+} gemm_f64_t;
+
+typedef struct {
+    int M, N, K;
+    gemm_trans_t ta, tb;
+    float alpha, beta;
+    const float *A, *B;
+    float *C;
+    size_t lda, ldb, ldc;
+    size_t a_rs, a_cs, b_rs, b_cs;
+} gemm_f32_t;
+
+// 参数合法返回 0，维度为负或跨度小于对应的行（列）长度返回 -1
+int gemm_f64_setup(gemm_f64_t *g, gemm_order_t order, gemm_trans_t ta, gemm_trans_t tb,
+                   int M, int N, int K, double alpha, const double *A, size_t lda,
+                   const double *B, size_t ldb, double beta, double *C, size_t ldc);
+int gemm_f32_setup(gemm_f32_t *g, gemm_order_t order, gemm_trans_t ta, gemm_trans_t tb,
+                   int M, int N, int K, float alpha, const float *A, size_t lda,
+                   const float *B, size_t ldb, float beta, float *C, size_t ldc);
+
+// 计算统一后 C 的行 [i0, i1)、列 [j0, j1)，不同块之间可并行
+void gemm_f64_block(const gemm_f64_t *g, int i0, int i1, int j0, int j1);
+void gemm_f32_block(const gemm_f32_t *g, int i0, int i1, int j0, int j1);
+
+// 串行完整 GEMM，参数非法返回 -1
+int gemm_f64(gemm_order_t order, gemm_trans_t ta, gemm_trans_t tb, int M, int N, int K,
+             double alpha, const double *A, size_t lda, const double *B, size_t ldb,
+             double beta, double *C, size_t ldc);
+int gemm_f32(gemm_order_t order, gemm_trans_t ta, gemm_trans_t tb, int M, int N, int K,
+             float alpha, const float *A, size_t lda, const float *B, size_t ldb,
+             float beta, float *C, size_t ldc);
+
+// 被测核：按 order / ta / tb / ... 计算完整 GEMM，ctx 为调用者数据
+typedef void (*gemm_f64_fn)(gemm_order_t order, gemm_trans_t ta, gemm_trans_t tb, int M, int N, int K,
+                            double alpha, const double *A, size_t lda, const double *B, size_t ldb,
+                            double beta, double *C, size_t ldc, void *ctx);
+typedef void (*gemm_f32_fn)(gemm_order_t order, gemm_trans_t ta, gemm_trans_t tb, int M, int N, int K,
+                            float alpha, const float *A, size_t lda, const float *B, size_t ldb,
+                            float beta, float *C, size_t ldc, void *ctx);
+
+// 返回最大相对误差（double 约 1e-15、float 约 1e-6 量级为正常），内存不足返回 -1
+double gemm_selftest_f64(gemm_f64_fn fn, void *ctx);
+double gemm_selftest_f32(gemm_f32_fn fn, void *ctx);
+
+#endif
@@ -0,0 +1,146 @@
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "matrix_arena.h"
+
+#define ARENA_HUGE_2M (2UL << 20)
+#define ARENA_HUGE_1GB (1UL << 30)
+
+#ifdef MAP_POPULATE
+#define MAP_POPULATE_FLAG MAP_POPULATE
+#else
+#define MAP_POPULATE_FLAG 0
+#endif
+
+static size_t arena_page(void) {
+    return (size_t)sysconf(_SC_PAGESIZE);
+}
+
+static size_t round_up(size_t x, size_t align) {
+    return (x + align - 1) / align * align;
+}
+
+// hugetlbfs 大页：预留不足时 mmap 直接失败，返回 NULL 由调用者退回
+static void *map_hugetlb(mat_arena_t *a, size_t bytes, int mflags, int flags) {
+#ifdef MAP_HUGETLB
+    size_t huge = (flags & ARENA_HUGE_1G) ? ARENA_HUGE_1GB : ARENA_HUGE_2M;
+    int hflags = MAP_HUGETLB;
+#ifdef MAP_HUGE_SHIFT
+    hflags |= ((flags & ARENA_HUGE_1G) ? 30 : 21) << MAP_HUGE_SHIFT;
+#endif
+    size_t len = round_up(bytes, huge);
+    void *p = mmap(NULL, len, PROT_READ | PROT_WRITE, mflags | hflags, -1, 0);
+    if (p == MAP_FAILED) return NULL;
+    a->map = p;
+    a->map_len = len;
+    a->capacity = len;
+    a->backing = ARENA_HUGETLB | (flags & ARENA_HUGE_1G);
+    return p;
+#else
+    (void)a; (void)bytes; (void)mflags; (void)flags;
+    return NULL;
+#endif
+}
+
+// 透明大页：多映射 2 MB 以便把起始地址对齐到大页边界，再建议内核使用大页
+static void *map_thp(mat_arena_t *a, size_t bytes, int mflags) {
+#ifdef MADV_HUGEPAGE
+    size_t len = round_up(bytes, ARENA_HUGE_2M);
+    void *p = mmap(NULL, len + ARENA_HUGE_2M, PROT_READ | PROT_WRITE, mflags & ~MAP_POPULATE_FLAG, -1, 0);
+    if (p == MAP_FAILED) return NULL;
+    char *base = (char *)round_up((uintptr_t)p, ARENA_HUGE_2M);
+    if (madvise(base, len, MADV_HUGEPAGE) != 0) {
+        munmap(p, len + ARENA_HUGE_2M);
+        return NULL;
+    }
+    a->map = p;
+    a->map_len = len + ARENA_HUGE_2M;
+    a->capacity = len;
+    a->backing = ARENA_HUGEPAGE;
+    // MAP_POPULATE 在 madvise 之前生效会先分配普通页，因此大页映射在建议之后再预先写入
+    if (mflags & MAP_POPULATE_FLAG) memset(base, 0, len);
+    return base;
+#else
+    (void)a; (void)bytes; (void)mflags;
+    return NULL;
+#endif
+}
+
+int arena_init(mat_arena_t *a, size_t bytes, int flags) {
+    size_t page = arena_page();
+    if (bytes == 0) bytes = page;
+    a->used = 0;
+    a->backing = 0;
+    int mflags = MAP_PRIVATE | MAP_ANONYMOUS;
+    if (flags & ARENA_POPULATE) mflags |= MAP_POPULATE_FLAG;
+
+    void *p = NULL;
+    if (flags & ARENA_HUGETLB) p = map_hugetlb(a, bytes, mflags, flags);
+    if (!p && (flags & (ARENA_HUGETLB | ARENA_HUGEPAGE))) p = map_thp(a, bytes, mflags);
+    if (!p) {
+        a->capacity = round_up(bytes, page);
+        p = mmap(NULL, a->capacity, PROT_READ | PROT_WRITE, mflags, -1, 0);
+        if (p == MAP_FAILED) {
+            a->base = NULL;
+            a->map = NULL;
+            a->capacity = a->map_len = 0;
+            return -1;
+        }
+        a->map = p;
+        a->map_len = a->capacity;
+    }
+    a->base = (char *)p;
+    return 0;
+}
+
+void *arena_alloc(mat_arena_t *a, size_t bytes) {
+    size_t off = (a->used + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+    if (off > a->capacity || bytes > a->capacity - off) return NULL;
+    a->used = off + bytes;
+    return a->base + off;
+}
+
+void arena_reset(mat_arena_t *a) {
+    a->used = 0;
+}
+
+void arena_touch(mat_arena_t *a, int part, int nparts) {
+    // 大页按大页粒度交错，避免一个大页被多个线程各写一部分
+    size_t page = (a->backing & ARENA_HUGE_1G) ? ARENA_HUGE_1GB :
+                  a->backing ? ARENA_HUGE_2M : arena_page();
+    size_t pages = (a->capacity + page - 1) / page;
+    for (size_t p = (size_t)part; p < pages; p += (size_t)nparts) ((volatile char *)a->base)[p * page] = 0;
+}
+
+void arena_destroy(mat_arena_t *a) {
+    if (a->map) munmap(a->map, a->map_len);
+    a->base = NULL;
+    a->map = NULL;
+    a->capacity = a->map_len = a->used = 0;
+}
+
+static int arena_page_flags_from_env(void) {
+    const char *s = getenv("ARENA_PAGES");
+    if (!s || !*s || strcmp(s, "4k") == 0) return 0;
+    if (strcmp(s, "thp") == 0) return ARENA_HUGEPAGE;
+    if (strcmp(s, "2m") == 0) return ARENA_HUGETLB;
+    if (strcmp(s, "1g") == 0) return ARENA_HUGETLB | ARENA_HUGE_1G;
+    return 0;
+}
+
+int arena_flags_from_env(void) {
+    const char *s = getenv("ARENA_POPULATE");
+    int populate = (s && *s && strcmp(s, "0") != 0) ? ARENA_POPULATE : 0;
+    return arena_page_flags_from_env() | populate;
+}
+
+const char *arena_backing_name(const mat_arena_t *a) {
+    if (a->backing & ARENA_HUGETLB) return (a->backing & ARENA_HUGE_1G) ? "1g" : "2m";
+    if (a->backing & ARENA_HUGEPAGE) return "thp";
+    return "4k";
+}
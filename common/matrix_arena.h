@@ -0,0 +1,65 @@
+#ifndef MATRIX_ARENA_H
+#define MATRIX_ARENA_H
+
+#include <stddef.h>
+
+/*
+ * 文件：matrix_arena.h
+ * 功能：测试程序共用的矩阵内存池。程序启动时按最大规模一次性映射，
+ *       每个测试用例开始时 arena_reset，再用 arena_alloc 依次取出各矩阵，
+ *       不同规模、线程数、调度方式之间不再 malloc/free，计时中不包含缺页与清零开销。
+ *
+ * 首次访问：默认映射后不触碰物理页，由程序在初始化阶段调用 arena_touch，
+ *   用计算线程（OpenMP 线程、parallel_for 工作线程或 pthread）按页轮流写入：第 p 页由第 p % nparts 个
+ *   线程写入，物理页交错分布在这些线程所在的 NUMA 节点上（相当于 numactl --interleave）。
+ *   这只是粗粒度的交错，不保证“哪个线程计算就落在哪个节点”：池在启动时只触碰一次，
+ *   之后各用例从池的起点切出不同规模的矩阵、按不同的划分计算，页的位置无法随用例改变；
+ *   交错保证任意规模的用例（包括只占池开头一小段的小用例）都均匀使用各节点的内存带宽，
+ *   不会全部落在第 0 个线程的节点上。
+ *   ARENA_POPULATE 则在映射时由调用线程一次性预先分配所有页（Linux MAP_POPULATE），
+ *   适合单 NUMA 节点的机器；之后的 arena_touch 不再改变页的位置。
+ *
+ * 大页：2048x2048 的 double 矩阵有 32 MB，用 4 KB 页时矩阵运算与模板计算的 dTLB 缺失很多。
+ *   ARENA_HUGEPAGE  映射按 2 MB 对齐并 madvise(MADV_HUGEPAGE)，由内核透明大页（THP）合并
+ *   ARENA_HUGETLB   用 MAP_HUGETLB 从 hugetlbfs 预留的 2 MB 大页分配（需先设置 vm.nr_hugepages），
+ *                   与 ARENA_HUGE_1G 同用时申请 1 GB 大页；预留不足时依次退回 THP、普通页
+ *   arena_flags_from_env 读取环境变量 ARENA_PAGES=4k|thp|2m|1g，arena_backing_name 给出实际使用的页类型。
+ *   环境变量 ARENA_POPULATE=1 时 arena_flags_from_env 另外加上 ARENA_POPULATE。
+ */
+
+#define ARENA_POPULATE 1
+#define ARENA_HUGEPAGE 2
+#define ARENA_HUGETLB  4
+#define ARENA_HUGE_1G  8
+#define ARENA_ALIGN    64     // arena_alloc 返回的地址按缓存行对齐
+
+typedef struct {
+    char *base;
+    size_t capacity;     // 映射的字节数（按页向上取整）
+    size_t used;         // 已分出的字节数
+    void *map;           // mmap 返回的地址与长度（THP 时为对齐而多映射了一段）
+    size_t map_len;
+    int backing;         // 实际使用的页类型：ARENA_HUGEPAGE / ARENA_HUGETLB(|ARENA_HUGE_1G) / 0 普通页
+} mat_arena_t;
+
+// 成功返回 0
+int arena_init(mat_arena_t *a, size_t bytes, int flags);
+
+// 从池中取出 bytes 字节，空间不足返回 NULL
+void *arena_alloc(mat_arena_t *a, size_t bytes);
+
+// 释放所有已分出的视图（内存保留，内容不清零）
+void arena_reset(mat_arena_t *a);
+
+// 写入第 part, part + nparts, part + 2 nparts, ... 页（按页轮流交错）；各线程以自己的编号并行调用
+void arena_touch(mat_arena_t *a, int part, int nparts);
+
+void arena_destroy(mat_arena_t *a);
+
+// 由环境变量 ARENA_PAGES 得到页类型标志，未设置时为 0（普通页）；ARENA_POPULATE=1 时加上 ARENA_POPULATE
+int arena_flags_from_env(void);
+
+// "4k" / "thp" / "2m" / "1g"
+const char *arena_backing_name(const mat_arena_t *a);
+
+#endif
@@ -0,0 +1,301 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+#include "parallel_reduce.h"
+#include "thread_affinity.h"
+
+#define PR_MAX_THREADS 256
+#define PR_MIN_PER_THREAD 16384   // 每个线程至少处理的元素数，小于此规模不值得创建线程
+
+// 每个线程的局部结果独占一个缓存行
+typedef union {
+    long long i;
+    double d;
+    float f;
+    int v;
+    char pad[PR_CACHE_LINE];
+} pr_slot_t;
+
+typedef struct {
+    pr_block_fn fn;
+    void *ctx;
+    int tid;
+    long long begin;
+    long long end;
+} pr_task_t;
+
+static void *pr_worker(void *p) {
+    pr_task_t *t = (pr_task_t *)p;
+    affinity_bind_self(t->tid);
+    t->fn(t->ctx, t->tid, t->begin, t->end);
+    return NULL;
+}
+
+// 在调用线程中执行一块（不改变调用线程的绑核）
+static void pr_run_here(pr_task_t *t) {
+    t->fn(t->ctx, t->tid, t->begin, t->end);
+}
+
+// 根据数据量确定实际使用的线程数
+static int pr_threads_for(long long n, int num_threads) {
+    if (num_threads <= 0) num_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (num_threads > PR_MAX_THREADS) num_threads = PR_MAX_THREADS;
+    long long useful = n / PR_MIN_PER_THREAD;
+    if (useful < num_threads) num_threads = (int)useful;
+    return num_threads < 1 ? 1 : num_threads;
+}
+
+/* 把 [0, n) 切成 num_threads 个连续块并行执行 fn。不绑核时线程 0 由调用者自己执行；
+   绑核时每块都在新线程中执行并绑到对应 CPU，调用线程的绑核保持不变。
+   线程创建失败时由调用者串行完成对应的块。 */
+static void pr_fork_join(long long n, int num_threads, pr_block_fn fn, void *ctx) {
+    pthread_t threads[PR_MAX_THREADS];
+    pr_task_t tasks[PR_MAX_THREADS];
+    int created[PR_MAX_THREADS];
+    const int first = (num_threads > 1 && affinity_cpu_for(0) >= 0) ? 0 : 1;
+
+    for (int t = 0; t < num_threads; ++t) {
+        tasks[t] = (pr_task_t){ fn, ctx, t, n * t / num_threads, n * (t + 1) / num_threads };
+        created[t] = 0;
+    }
+    for (int t = first; t < num_threads; ++t)
+        created[t] = (pthread_create(&threads[t], NULL, pr_worker, &tasks[t]) == 0);
+    if (first == 1) pr_run_here(&tasks[0]);
+    for (int t = first; t < num_threads; ++t) {
+        if (created[t]) pthread_join(threads[t], NULL);
+        else            pr_run_here(&tasks[t]);
+    }
+}
+
+void pr_for(long long n, int num_threads, pr_block_fn fn, void *ctx) {
+    pr_fork_join(n, pr_threads_for(n, num_threads), fn, ctx);
+}
+
+static pr_slot_t *pr_alloc_slots(int count) {
+    void *p = NULL;
+    if (posix_memalign(&p, PR_CACHE_LINE, sizeof(pr_slot_t) * (size_t)count) != 0) {
+        fprintf(stderr, "parallel_reduce: 内存分配失败\n");
+        exit(EXIT_FAILURE);
+    }
+    return (pr_slot_t *)p;
+}
+
+/* ------------------------------------------------------------------------ */
+/* 求和：ACC 为累加类型，FIELD 为 pr_slot_t 中对应的成员                     */
+/* ------------------------------------------------------------------------ */
+
+// 对 a[0, n) 求和：int32 加宽为 int64 后用 SIMD 累加，避免溢出
+static long long pr_block_sum_i32(const int *a, long long n) {
+    long long i = 0, sum = 0;
+#if defined(__AVX2__)
+    __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+    __m256i acc2 = _mm256_setzero_si256(), acc3 = _mm256_setzero_si256();
+    for (; i + 16 <= n; i += 16) {
+        __m256i v0 = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i v1 = _mm256_loadu_si256((const __m256i *)(a + i + 8));
+        acc0 = _mm256_add_epi64(acc0, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v0)));
+        acc1 = _mm256_add_epi64(acc1, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v0, 1)));
+        acc2 = _mm256_add_epi64(acc2, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v1)));
+        acc3 = _mm256_add_epi64(acc3, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v1, 1)));
+    }
+    long long lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes,
+        _mm256_add_epi64(_mm256_add_epi64(acc0, acc1), _mm256_add_epi64(acc2, acc3)));
+    sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(__ARM_NEON)
+    int64x2_t acc0 = vdupq_n_s64(0), acc1 = vdupq_n_s64(0);
+    int64x2_t acc2 = vdupq_n_s64(0), acc3 = vdupq_n_s64(0);
+    for (; i + 16 <= n; i += 16) {
+        acc0 = vpadalq_s32(acc0, vld1q_s32(a + i));
+        acc1 = vpadalq_s32(acc1, vld1q_s32(a + i + 4));
+        acc2 = vpadalq_s32(acc2, vld1q_s32(a + i + 8));
+        acc3 = vpadalq_s32(acc3, vld1q_s32(a + i + 12));
+    }
+    sum = vaddvq_s64(vaddq_s64(vaddq_s64(acc0, acc1), vaddq_s64(acc2, acc3)));
+#else
+    long long s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += a[i]; s1 += a[i + 1]; s2 += a[i + 2]; s3 += a[i + 3];
+    }
+    sum = (s0 + s1) + (s2 + s3);
+#endif
+    for (; i < n; i++) sum += a[i];
+    return sum;
+}
+
+// 浮点数组的块求和：4 路独立累加，由编译器向量化
+#define PR_DEFINE_BLOCK_SUM(SUFFIX, T, ACC)                                      \
+static ACC pr_block_sum_##SUFFIX(const T *a, long long n) {                      \
+    ACC s0 = 0, s1 = 0, s2 = 0, s3 = 0;                                          \
+    long long i = 0;                                                             \
+    for (; i + 4 <= n; i += 4) {                                                 \
+        s0 += a[i]; s1 += a[i + 1]; s2 += a[i + 2]; s3 += a[i + 3];              \
+    }                                                                            \
+    for (; i < n; ++i) s0 += a[i];                                               \
+    return (s0 + s1) + (s2 + s3);                                                \
+}
+
+PR_DEFINE_BLOCK_SUM(f32, float,  double)
+PR_DEFINE_BLOCK_SUM(f64, double, double)
+
+#define PR_DEFINE_SUM(SUFFIX, T, ACC, FIELD)                                     \
+typedef struct { const T *a; pr_slot_t *slots; } pr_sum_ctx_##SUFFIX;            \
+static void pr_sum_block_##SUFFIX(void *p, int tid, long long b, long long e) {  \
+    pr_sum_ctx_##SUFFIX *c = (pr_sum_ctx_##SUFFIX *)p;                           \
+    c->slots[tid].FIELD = pr_block_sum_##SUFFIX(c->a + b, e - b);                \
+}                                                                                \
+ACC pr_sum_##SUFFIX(const T *a, long long n, int num_threads) {                  \
+    int nt = pr_threads_for(n, num_threads);                                     \
+    pr_slot_t *slots = pr_alloc_slots(nt);                                       \
+    pr_sum_ctx_##SUFFIX ctx = { a, slots };                                      \
+    pr_fork_join(n, nt, pr_sum_block_##SUFFIX, &ctx);                            \
+    ACC total = 0;                                                               \
+    for (int t = 0; t < nt; ++t) total += slots[t].FIELD;                        \
+    free(slots);                                                                 \
+    return total;                                                                \
+}
+
+PR_DEFINE_SUM(i32, int,    long long, i)
+PR_DEFINE_SUM(f32, float,  double,    d)
+PR_DEFINE_SUM(f64, double, double,    d)
+
+/* ------------------------------------------------------------------------ */
+/* 最小值 / 最大值：CMP 为“x 优于 best”的比较运算符                          */
+/* ------------------------------------------------------------------------ */
+
+#define PR_DEFINE_EXTREMUM(NAME, SUFFIX, T, FIELD, CMP)                          \
+typedef struct { const T *a; pr_slot_t *slots; } pr_##NAME##_ctx_##SUFFIX;       \
+static void pr_##NAME##_block_##SUFFIX(void *p, int tid, long long b, long long e) { \
+    pr_##NAME##_ctx_##SUFFIX *c = (pr_##NAME##_ctx_##SUFFIX *)p;                 \
+    T best = c->a[b];                                                            \
+    for (long long i = b + 1; i < e; ++i)                                        \
+        if (c->a[i] CMP best) best = c->a[i];                                    \
+    c->slots[tid].FIELD = best;                                                  \
+}                                                                                \
+T pr_##NAME##_##SUFFIX(const T *a, long long n, int num_threads) {               \
+    int nt = pr_threads_for(n, num_threads);                                     \
+    pr_slot_t *slots = pr_alloc_slots(nt);                                       \
+    pr_##NAME##_ctx_##SUFFIX ctx = { a, slots };                                 \
+    pr_fork_join(n, nt, pr_##NAME##_block_##SUFFIX, &ctx);                       \
+    T best = slots[0].FIELD;                                                     \
+    for (int t = 1; t < nt; ++t)                                                 \
+        if (slots[t].FIELD CMP best) best = slots[t].FIELD;                      \
+    free(slots);                                                                 \
+    return best;                                                                 \
+}
+
+PR_DEFINE_EXTREMUM(min, i32, int,    v, <)
+PR_DEFINE_EXTREMUM(min, f32, float,  f, <)
+PR_DEFINE_EXTREMUM(min, f64, double, d, <)
+PR_DEFINE_EXTREMUM(max, i32, int,    v, >)
+PR_DEFINE_EXTREMUM(max, f32, float,  f, >)
+PR_DEFINE_EXTREMUM(max, f64, double, d, >)
+
+/* ------------------------------------------------------------------------ */
+/* 前缀和：两遍分块。第一遍求块和，串行扫描块和得到各块偏移，第二遍带偏移扫描 */
+/* ------------------------------------------------------------------------ */
+
+#define PR_DEFINE_SCAN(SUFFIX, T, OUT_T, ACC, FIELD)                             \
+typedef struct { const T *a; OUT_T *out; pr_slot_t *slots; int inclusive; }      \
+    pr_scan_ctx_##SUFFIX;                                                        \
+static void pr_scan_sum_##SUFFIX(void *p, int tid, long long b, long long e) {   \
+    pr_scan_ctx_##SUFFIX *c = (pr_scan_ctx_##SUFFIX *)p;                         \
+    c->slots[tid].FIELD = pr_block_sum_##SUFFIX(c->a + b, e - b);                \
+}                                                                                \
+static void pr_scan_apply_##SUFFIX(void *p, int tid, long long b, long long e) { \
+    pr_scan_ctx_##SUFFIX *c = (pr_scan_ctx_##SUFFIX *)p;                         \
+    ACC run = c->slots[tid].FIELD;                                               \
+    if (c->inclusive) {                                                          \
+        for (long long i = b; i < e; ++i) { run += c->a[i]; c->out[i] = (OUT_T)run; } \
+    } else {                                                                     \
+        for (long long i = b; i < e; ++i) {                                      \
+            ACC x = c->a[i]; c->out[i] = (OUT_T)run; run += x;                   \
+        }                                                                        \
+    }                                                                            \
+}                                                                                \
+static void pr_scan_##SUFFIX(const T *a, OUT_T *out, long long n,                \
+                             int num_threads, int inclusive) {                   \
+    int nt = pr_threads_for(n, num_threads);                                     \
+    pr_slot_t *slots = pr_alloc_slots(nt);                                       \
+    pr_scan_ctx_##SUFFIX ctx = { a, out, slots, inclusive };                     \
+    if (nt > 1) {                                                                \
+        pr_fork_join(n, nt, pr_scan_sum_##SUFFIX, &ctx);                         \
+        ACC offset = 0;                                                          \
+        for (int t = 0; t < nt; ++t) {                                           \
+            ACC block = slots[t].FIELD;                                          \
+            slots[t].FIELD = offset;                                             \
+            offset += block;                                                     \
+        }                                                                        \
+    } else {                                                                     \
+        slots[0].FIELD = 0;                                                      \
+    }                                                                            \
+    pr_fork_join(n, nt, pr_scan_apply_##SUFFIX, &ctx);                           \
+    free(slots);                                                                 \
+}                                                                                \
+void pr_inclusive_scan_##SUFFIX(const T *a, OUT_T *out, long long n, int num_threads) { \
+    pr_scan_##SUFFIX(a, out, n, num_threads, 1);                                 \
+}                                                                                \
+void pr_exclusive_scan_##SUFFIX(const T *a, OUT_T *out, long long n, int num_threads) { \
+    pr_scan_##SUFFIX(a, out, n, num_threads, 0);                                 \
+}
+
+// float 的前缀和在 double 中累加（块和、块偏移与块内累加），只在写出时舍入为 float
+PR_DEFINE_SCAN(i32, int,    long long, long long, i)
+PR_DEFINE_SCAN(f32, float,  float,     double,    d)
+PR_DEFINE_SCAN(f64, double, double,    double,    d)
+
+/* ------------------------------------------------------------------------ */
+/* 直方图：每个线程写私有的计数数组（按缓存行对齐分配），最后合并            */
+/* ------------------------------------------------------------------------ */
+
+#define PR_DEFINE_HISTOGRAM(SUFFIX, T)                                           \
+typedef struct { const T *a; double lo, hi; int nbins; long long **local; }      \
+    pr_hist_ctx_##SUFFIX;                                                        \
+static void pr_hist_block_##SUFFIX(void *p, int tid, long long b, long long e) { \
+    pr_hist_ctx_##SUFFIX *c = (pr_hist_ctx_##SUFFIX *)p;                         \
+    long long *h = c->local[tid];                                                \
+    const double scale = c->nbins / (c->hi - c->lo);                             \
+    for (long long i = b; i < e; ++i) {                                          \
+        double x = (double)c->a[i];                                              \
+        if (x >= c->lo && x < c->hi) {                                           \
+            int bin = (int)((x - c->lo) * scale);                                \
+            if (bin >= c->nbins) bin = c->nbins - 1;                             \
+            h[bin]++;                                                            \
+        }                                                                        \
+    }                                                                            \
+}                                                                                \
+void pr_histogram_##SUFFIX(const T *a, long long n, double lo, double hi,        \
+                           int nbins, long long *counts, int num_threads) {      \
+    int nt = pr_threads_for(n, num_threads);                                     \
+    long long *local[PR_MAX_THREADS];                                            \
+    size_t bytes = sizeof(long long) * (size_t)nbins;                            \
+    bytes = (bytes + PR_CACHE_LINE - 1) / PR_CACHE_LINE * PR_CACHE_LINE;         \
+    for (int t = 0; t < nt; ++t) {                                               \
+        void *q = NULL;                                                          \
+        if (posix_memalign(&q, PR_CACHE_LINE, bytes) != 0) {                     \
+            fprintf(stderr, "parallel_reduce: 内存分配失败\n");                  \
+            exit(EXIT_FAILURE);                                                  \
+        }                                                                        \
+        memset(q, 0, bytes);                                                     \
+        local[t] = (long long *)q;                                               \
+    }                                                                            \
+    pr_hist_ctx_##SUFFIX ctx = { a, lo, hi, nbins, local };                      \
+    pr_fork_join(n, nt, pr_hist_block_##SUFFIX, &ctx);                           \
+    for (int k = 0; k < nbins; ++k) {                                            \
+        long long s = 0;                                                         \
+        for (int t = 0; t < nt; ++t) s += local[t][k];                           \
+        counts[k] = s;                                                           \
+    }                                                                            \
+    for (int t = 0; t < nt; ++t) free(local[t]);                                 \
+}
+
+PR_DEFINE_HISTOGRAM(i32, int)
+PR_DEFINE_HISTOGRAM(f32, float)
+PR_DEFINE_HISTOGRAM(f64, double)
@@ -0,0 +1,59 @@
+#ifndef PARALLEL_REDUCE_H
+#define PARALLEL_REDUCE_H
+
+/*
+ * 文件：parallel_reduce.h
+ * 功能：基于 pthread 的通用并行归约 / 前缀和 / 直方图，支持 int、float、double 数组。
+ *       数组按线程数切成连续块，每个线程的局部结果放在独立的缓存行中，避免伪共享。
+ *
+ * 约定：
+ *   - num_threads <= 0 时使用在线 CPU 数；数据量较小时自动退化为单线程。
+ *   - 对同样的 (n, num_threads)，所有函数与 pr_for 使用相同的线程数和相同的连续块，
+ *     第 t 块总由第 t 个线程处理；工作线程按 common/thread_affinity.h 的策略（PT_PROC_BIND /
+ *     PT_PLACES）绑定到第 t 个 CPU。因此先用 pr_for 并行首次访问数组，之后的归约读取的
+ *     正是本线程首次访问、位于本 NUMA 节点的页。
+ *   - int 的求和与前缀和用 long long 累加，float 的求和与前缀和用 double 累加。
+ *     int 求和在 AVX2 / NEON 下先加宽为 int64 再做 SIMD 累加。
+ *   - 前缀和采用两遍分块算法：先并行求各块之和，再对块和做串行前缀和，
+ *     最后各线程带偏移量扫描自己的块。float / double 的 out 可以与 in 相同（原地扫描）。
+ *   - 直方图把 [lo, hi) 等分为 nbins 个桶，区间外的元素不计数；counts 会被清零后写入。
+ *
+ * 编译时需同时链接 thread_affinity.c。
+ */
+
+#define PR_CACHE_LINE 64
+
+// 第 tid 个线程处理 [begin, end)
+typedef void (*pr_block_fn)(void *ctx, int tid, long long begin, long long end);
+
+// 用与归约相同的线程数与划分并行执行 fn，例如首次访问初始化
+void pr_for(long long n, int num_threads, pr_block_fn fn, void *ctx);
+
+long long pr_sum_i32(const int *a, long long n, int num_threads);
+double    pr_sum_f32(const float *a, long long n, int num_threads);
+double    pr_sum_f64(const double *a, long long n, int num_threads);
+
+// n 必须大于 0
+int    pr_min_i32(const int *a, long long n, int num_threads);
+float  pr_min_f32(const float *a, long long n, int num_threads);
+double pr_min_f64(const double *a, long long n, int num_threads);
+int    pr_max_i32(const int *a, long long n, int num_threads);
+float  pr_max_f32(const float *a, long long n, int num_threads);
+double pr_max_f64(const double *a, long long n, int num_threads);
+
+// inclusive: out[i] = a[0] + ... + a[i]；exclusive: out[i] = a[0] + ... + a[i-1]，out[0] = 0
+void pr_inclusive_scan_i32(const int *a, long long *out, long long n, int num_threads);
+void pr_inclusive_scan_f32(const float *a, float *out, long long n, int num_threads);
+void pr_inclusive_scan_f64(const double *a, double *out, long long n, int num_threads);
+void pr_exclusive_scan_i32(const int *a, long long *out, long long n, int num_threads);
+void pr_exclusive_scan_f32(const float *a, float *out, long long n, int num_threads);
+void pr_exclusive_scan_f64(const double *a, double *out, long long n, int num_threads);
+
+void pr_histogram_i32(const int *a, long long n, double lo, double hi,
+                      int nbins, long long *counts, int num_threads);
+void pr_histogram_f32(const float *a, long long n, double lo, double hi,
+                      int nbins, long long *counts, int num_threads);
+void pr_histogram_f64(const double *a, long long n, double lo, double hi,
+                      int nbins, long long *counts, int num_threads);
+
+#endif
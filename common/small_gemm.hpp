@@ -0,0 +1,94 @@
+#ifndef SMALL_GEMM_HPP
+#define SMALL_GEMM_HPP
+
+/*
+ * 文件：small_gemm.hpp（C++17，仅头文件）
+ * 功能：规模在编译期确定的小矩阵乘法核，以及连续存放的大批量小矩阵乘法。
+ *
+ * 小矩阵（4x4 ~ 32x32）的乘法中，通用三重循环的循环控制、边界判断与下标计算占了大部分时间。
+ * 这里把 M、N、K 作为模板参数：C 的一行在局部数组中累加（编译器放进向量寄存器），
+ * 公共维与列方向的循环次数都是常量，被完全展开，没有任何运行时边界判断。
+ *
+ * 批量接口：第 b 个矩阵位于 A + b*M*N、B + b*N*K、C + b*M*K（行主序、紧密排列），
+ * 各矩阵相互独立，用 OpenMP 在批次维度上并行（未开启 OpenMP 时串行执行）。
+ * small_gemm_batched 在运行时按 (m, n, k) 选择已实例化的方阵版本（4、8、...、32），
+ * 其他规模退回通用循环。
+ */
+
+#include <cstddef>
+
+#if defined(__clang__)
+#define SG_UNROLL _Pragma("unroll")
+#elif defined(__GNUC__)
+#define SG_UNROLL _Pragma("GCC unroll 32")
+#else
+#define SG_UNROLL
+#endif
+
+// C = A * B，A 为 M x N，B 为 N x K，C 为 M x K，均按行紧密存放
+template <int M, int N, int K, typename T>
+inline void small_gemm(const T *__restrict A, const T *__restrict B, T *__restrict C) {
+    for (int i = 0; i < M; ++i) {
+        T c[K] = {};
+        SG_UNROLL
+        for (int l = 0; l < N; ++l) {
+            const T a = A[i * N + l];
+            SG_UNROLL
+            for (int j = 0; j < K; ++j) c[j] += a * B[l * K + j];
+        }
+        SG_UNROLL
+        for (int j = 0; j < K; ++j) C[i * K + j] = c[j];
+    }
+}
+
+// 通用版本：规模在运行时给出，与 small_gemm 计算顺序相同，用于不支持的规模及对比
+template <typename T>
+inline void small_gemm_generic(int m, int n, int k, const T *A, const T *B, T *C) {
+    for (int i = 0; i < m; ++i) {
+        for (int j = 0; j < k; ++j) C[i * k + j] = T(0);
+        for (int l = 0; l < n; ++l) {
+            const T a = A[i * n + l];
+            for (int j = 0; j < k; ++j) C[i * k + j] += a * B[l * k + j];
+        }
+    }
+}
+
+// 批量：batch 个相互独立的 M x N 乘 N x K
+template <int M, int N, int K, typename T>
+void small_gemm_batch(long batch, const T *A, const T *B, T *C) {
+#pragma omp parallel for schedule(static)
+    for (long b = 0; b < batch; ++b)
+        small_gemm<M, N, K>(A + (size_t)b * M * N, B + (size_t)b * N * K, C + (size_t)b * M * K);
+}
+
+template <typename T>
+void small_gemm_batch_generic(int m, int n, int k, long batch, const T *A, const T *B, T *C) {
+#pragma omp parallel for schedule(static)
+    for (long b = 0; b < batch; ++b)
+        small_gemm_generic(m, n, k, A + (size_t)b * m * n, B + (size_t)b * n * k, C + (size_t)b * m * k);
+}
+
+/*
+ * 运行时分派：m == n == k 且为 4 ~ 32 中 4 的倍数时调用对应的特化版本并返回 1，
+ * 否则用通用循环计算并返回 0。
+ */
+template <typename T>
+int small_gemm_batched(int m, int n, int k, long batch, const T *A, const T *B, T *C) {
+    if (m == n && n == k) {
+        switch (m) {
+        case 4:  small_gemm_batch<4, 4, 4>(batch, A, B, C); return 1;
+        case 8:  small_gemm_batch<8, 8, 8>(batch, A, B, C); return 1;
+        case 12: small_gemm_batch<12, 12, 12>(batch, A, B, C); return 1;
+        case 16: small_gemm_batch<16, 16, 16>(batch, A, B, C); return 1;
+        case 20: small_gemm_batch<20, 20, 20>(batch, A, B, C); return 1;
+        case 24: small_gemm_batch<24, 24, 24>(batch, A, B, C); return 1;
+        case 28: small_gemm_batch<28, 28, 28>(batch, A, B, C); return 1;
+        case 32: small_gemm_batch<32, 32, 32>(batch, A, B, C); return 1;
+        default: break;
+        }
+    }
+    small_gemm_batch_generic(m, n, k, batch, A, B, C);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,260 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "sparse.h"
+#include "counter_rng.h"
+
+static double gen_weight(const sp_gen_t *g, int i) {
+    return g->skew == 0.0 ? 1.0 : pow((i + 0.5) / g->rows, -g->skew);
+}
+
+void sp_gen_init(sp_gen_t *g, int rows, int cols, double avg_nnz, double skew, uint64_t key) {
+    g->rows = rows;
+    g->cols = cols;
+    g->avg_nnz = avg_nnz;
+    g->skew = skew;
+    g->key = key;
+    // 归一化使行长期望的平均值为 avg_nnz
+    double sum = 0.0;
+    for (int i = 0; i < rows; i++) sum += gen_weight(g, i);
+    g->norm = sum > 0.0 ? rows / sum : 0.0;
+}
+
+int sp_gen_row_len(const sp_gen_t *g, int i) {
+    if (g->cols <= 0) return 0;
+    uint64_t rk = crng_key(g->key, (uint64_t)i);
+    double len = g->avg_nnz * gen_weight(g, i) * g->norm * (0.5 + crng_uniform(rk, 0));
+    if (len < 1.0) return 1;
+    if (len > g->cols) return g->cols;
+    return (int)(len + 0.5);
+}
+
+void sp_gen_row(const sp_gen_t *g, int i, int *col, double *val) {
+    uint64_t rk = crng_key(g->key, (uint64_t)i);
+    int len = sp_gen_row_len(g, i);
+    // 列方向等分为 len 段，每段随机取一列：列号升序且互不相同，且分散在整行
+    for (int j = 0; j < len; j++) {
+        long long lo = (long long)j * g->cols / len, hi = (long long)(j + 1) * g->cols / len;
+        col[j] = (int)(lo + crng_below(rk, 1 + 2 * (uint64_t)j, (uint32_t)(hi - lo)));
+        val[j] = 2.0 * crng_uniform(rk, 2 + 2 * (uint64_t)j) - 1.0;
+    }
+}
+
+int csr_generate(csr_t *A, const sp_gen_t *g, const int *row_list, int nrows) {
+    if (!row_list) nrows = g->rows;
+    memset(A, 0, sizeof(*A));
+    A->rows = nrows;
+    A->cols = g->cols;
+    A->row_ptr = malloc(sizeof(long long) * (nrows + 1));
+    if (!A->row_ptr) return -1;
+    A->row_ptr[0] = 0;
+    for (int i = 0; i < nrows; i++)
+        A->row_ptr[i + 1] = A->row_ptr[i] + sp_gen_row_len(g, row_list ? row_list[i] : i);
+    A->nnz = A->row_ptr[nrows];
+    A->col = malloc(sizeof(int) * (A->nnz > 0 ? A->nnz : 1));
+    A->val = malloc(sizeof(double) * (A->nnz > 0 ? A->nnz : 1));
+    if (!A->col || !A->val) {
+        csr_free(A);
+        return -1;
+    }
+    for (int i = 0; i < nrows; i++)
+        sp_gen_row(g, row_list ? row_list[i] : i, A->col + A->row_ptr[i], A->val + A->row_ptr[i]);
+    return 0;
+}
+
+void csr_free(csr_t *A) {
+    free(A->row_ptr);
+    free(A->col);
+    free(A->val);
+    memset(A, 0, sizeof(*A));
+}
+
+// σ 窗口内按行长降序排序，行长相同时保持原顺序；排序 (行长, 行号) 对，不依赖全局状态，可重入
+typedef struct {
+    long long len;
+    int row;
+} row_len_t;
+
+static int by_len_desc(const void *pa, const void *pb) {
+    const row_len_t *a = (const row_len_t *)pa, *b = (const row_len_t *)pb;
+    if (a->len != b->len) return a->len < b->len ? 1 : -1;
+    return (a->row > b->row) - (a->row < b->row);
+}
+
+int sell_from_csr(sell_t *S, const csr_t *A, int C, int sigma) {
+    memset(S, 0, sizeof(*S));
+    if (C < 1 || C > SELL_MAX_C) return -1;
+    if (sigma < C) sigma = C;
+    sigma = (sigma + C - 1) / C * C;
+    S->rows = A->rows;
+    S->cols = A->cols;
+    S->C = C;
+    S->sigma = sigma;
+    S->nnz = A->nnz;
+    S->nchunks = (A->rows + C - 1) / C;
+    const int slots = S->nchunks * C;
+    S->perm = malloc(sizeof(int) * (slots > 0 ? slots : 1));
+    S->chunk_len = malloc(sizeof(int) * (S->nchunks > 0 ? S->nchunks : 1));
+    S->chunk_ptr = malloc(sizeof(long long) * (S->nchunks + 1));
+    if (!S->perm || !S->chunk_len || !S->chunk_ptr) {
+        sell_free(S);
+        return -1;
+    }
+
+    for (int k = 0; k < slots; k++) S->perm[k] = k < A->rows ? k : -1;
+    row_len_t *keys = malloc(sizeof(row_len_t) * (size_t)(A->rows < sigma ? (A->rows > 0 ? A->rows : 1) : sigma));
+    if (!keys) {
+        sell_free(S);
+        return -1;
+    }
+    for (int w = 0; w < A->rows; w += sigma) {
+        int n = (A->rows - w < sigma) ? A->rows - w : sigma;
+        for (int r = 0; r < n; r++)
+            keys[r] = (row_len_t){A->row_ptr[w + r + 1] - A->row_ptr[w + r], w + r};
+        qsort(keys, n, sizeof(row_len_t), by_len_desc);
+        for (int r = 0; r < n; r++) S->perm[w + r] = keys[r].row;
+    }
+    free(keys);
+
+    S->chunk_ptr[0] = 0;
+    for (int c = 0; c < S->nchunks; c++) {
+        long long width = 0;
+        for (int r = 0; r < C; r++) {
+            int row = S->perm[c * C + r];
+            if (row >= 0 && A->row_ptr[row + 1] - A->row_ptr[row] > width)
+                width = A->row_ptr[row + 1] - A->row_ptr[row];
+        }
+        S->chunk_len[c] = (int)width;
+        S->chunk_ptr[c + 1] = S->chunk_ptr[c] + width * C;
+    }
+
+    const long long stored = S->chunk_ptr[S->nchunks];
+    S->col = calloc(stored > 0 ? stored : 1, sizeof(int));
+    S->val = calloc(stored > 0 ? stored : 1, sizeof(double));
+    if (!S->col || !S->val) {
+        sell_free(S);
+        return -1;
+    }
+    for (int c = 0; c < S->nchunks; c++)
+        for (int r = 0; r < C; r++) {
+            int row = S->perm[c * C + r];
+            if (row < 0) continue;
+            for (long long p = A->row_ptr[row]; p < A->row_ptr[row + 1]; p++) {
+                long long dst = S->chunk_ptr[c] + (p - A->row_ptr[row]) * C + r;
+                S->col[dst] = A->col[p];
+                S->val[dst] = A->val[p];
+            }
+        }
+    return 0;
+}
+
+void sell_free(sell_t *S) {
+    free(S->chunk_ptr);
+    free(S->chunk_len);
+    free(S->perm);
+    free(S->col);
+    free(S->val);
+    memset(S, 0, sizeof(*S));
+}
+
+void sp_split(const long long *prefix, int n, int nblocks, int *bounds) {
+    bounds[0] = 0;
+    int lo = 0;
+    for (int b = 1; b < nblocks; b++) {
+        if (!prefix) {
+            bounds[b] = (int)((long long)b * n / nblocks);
+            continue;
+        }
+        // 第一个前缀和不小于 b/nblocks 总量的位置
+        const double target = (double)prefix[n] * b / nblocks;
+        int hi = n;
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            if ((double)prefix[mid] < target) lo = mid + 1;
+            else hi = mid;
+        }
+        bounds[b] = lo;
+    }
+    bounds[nblocks] = n;
+}
+
+double sp_imbalance(const long long *prefix, const int *bounds, int nblocks, int parts) {
+    if (parts <= 0 || prefix[bounds[nblocks]] == prefix[bounds[0]]) return 1.0;
+    long long worst = 0;
+    for (int p = 0; p < parts; p++) {
+        long long work = 0;
+        for (int b = p; b < nblocks; b += parts) work += prefix[bounds[b + 1]] - prefix[bounds[b]];
+        if (work > worst) worst = work;
+    }
+    return (double)worst * parts / (double)(prefix[bounds[nblocks]] - prefix[bounds[0]]);
+}
+
+void csr_spmv(const csr_t *A, const double *x, double *y, int r0, int r1) {
+    for (int i = r0; i < r1; i++) {
+        double sum = 0.0;
+        for (long long p = A->row_ptr[i]; p < A->row_ptr[i + 1]; p++)
+            sum += A->val[p] * x[A->col[p]];
+        y[i] = sum;
+    }
+}
+
+void csr_spmm(const csr_t *A, const double *B, size_t ldb, int ncols,
+              double *C, size_t ldc, int r0, int r1) {
+    for (int i = r0; i < r1; i++) {
+        double *restrict c = C + (size_t)i * ldc;
+        for (int j = 0; j < ncols; j++) c[j] = 0.0;
+        for (long long p = A->row_ptr[i]; p < A->row_ptr[i + 1]; p++) {
+            const double v = A->val[p];
+            const double *restrict b = B + (size_t)A->col[p] * ldb;
+            for (int j = 0; j < ncols; j++) c[j] += v * b[j];
+        }
+    }
+}
+
+// 块高为编译期常量时最内层循环完全向量化；CH 以字面量传入，调用处被常量传播
+static inline void sell_spmv_fixed(const sell_t *S, const double *x, double *y, int c0, int c1,
+                                   const int CH) {
+    for (int c = c0; c < c1; c++) {
+        double acc[SELL_MAX_C] = {0};
+        const int *col = S->col + S->chunk_ptr[c];
+        const double *val = S->val + S->chunk_ptr[c];
+        for (int j = 0; j < S->chunk_len[c]; j++)
+            for (int r = 0; r < CH; r++)
+                acc[r] += val[j * CH + r] * x[col[j * CH + r]];
+        for (int r = 0; r < CH; r++) {
+            int row = S->perm[c * CH + r];
+            if (row >= 0) y[row] = acc[r];
+        }
+    }
+}
+
+void sell_spmv(const sell_t *S, const double *x, double *y, int c0, int c1) {
+    switch (S->C) {
+    case 4:  sell_spmv_fixed(S, x, y, c0, c1, 4); break;
+    case 8:  sell_spmv_fixed(S, x, y, c0, c1, 8); break;
+    case 16: sell_spmv_fixed(S, x, y, c0, c1, 16); break;
+    default: sell_spmv_fixed(S, x, y, c0, c1, S->C); break;
+    }
+}
+
+void sell_spmm(const sell_t *S, const double *B, size_t ldb, int ncols,
+               double *C, size_t ldc, int c0, int c1) {
+    const int CH = S->C;
+    for (int c = c0; c < c1; c++) {
+        const int *col = S->col + S->chunk_ptr[c];
+        const double *val = S->val + S->chunk_ptr[c];
+        // 块内逐行计算（跨度 C 读取该行的元素），输出行在整个累加过程中留在 L1；填充位置（值为 0）跳过
+        for (int r = 0; r < CH; r++) {
+            int row = S->perm[c * CH + r];
+            if (row < 0) continue;
+            double *restrict out = C + (size_t)row * ldc;
+            for (int k = 0; k < ncols; k++) out[k] = 0.0;
+            for (int j = 0; j < S->chunk_len[c]; j++) {
+                const double v = val[j * CH + r];
+                if (v == 0.0) continue;
+                const double *restrict b = B + (size_t)col[j * CH + r] * ldb;
+                for (int k = 0; k < ncols; k++) out[k] += v * b[k];
+            }
+        }
+    }
+}
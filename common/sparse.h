@@ -0,0 +1,87 @@
+#ifndef SPARSE_H
+#define SPARSE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * 文件：sparse.h
+ * 功能：稀疏矩阵格式 CSR 与 SELL-C-σ，以及按行（块）区间计算的 SpMV（y = A x）与
+ *       稀疏乘稠密 SpMM（C = A B，B、C 行主序带跨度），供 pthread / OpenMP / MPI 程序并行调用。
+ *
+ * SELL-C-σ：每 σ 行为一个窗口，窗口内按行长降序排列，再把每 C 行组成一个块（chunk），
+ *   块内按列优先存放、宽度补齐到块内最长行。同一块的 C 行在最内层同时计算，可向量化；
+ *   σ 越大补齐越少，但 x 的访问越分散。填充位置的值为 0、列号为 0。
+ *
+ * 划分：sp_split 按前缀和（CSR 的 row_ptr 或 SELL 的 chunk_ptr）把 [0, n) 切成 nblocks 个
+ *   非零元个数近似相等的连续区间；前缀为 NULL 时按行（块）数等分。
+ *   块划分取 nblocks = 线程（进程）数，第 p 个区间归第 p 个；
+ *   循环划分取 nblocks = 线程数 × 每线程块数，第 b 个区间归 b % 线程数。
+ *
+ * 生成器：sp_gen_* 为测试用的确定性稀疏矩阵，第 i 行的长度与内容只由 (种子, i) 决定
+ *   （common/counter_rng.h），可以只生成某些行；行长期望按 ((i + 0.5) / rows)^(-skew) 衰减，
+ *   skew = 0 时各行长度相近，skew 越大前面的行越稠密，等行数划分越不均衡。
+ */
+
+#define SELL_DEFAULT_C 8        // 块高：一个 AVX-512 向量的 double 个数
+#define SELL_DEFAULT_SIGMA 256  // 排序窗口
+#define SELL_MAX_C 32
+
+typedef struct {
+    int rows, cols;
+    long long nnz;
+    long long *row_ptr;         // rows + 1
+    int *col;                   // nnz，每行内升序
+    double *val;                // nnz
+} csr_t;
+
+typedef struct {
+    int rows, cols;
+    int C, sigma;
+    int nchunks;
+    long long nnz;              // 真实非零元个数
+    long long *chunk_ptr;       // nchunks + 1，第 c 块在 col / val 中的起点（含填充）
+    int *chunk_len;             // 第 c 块的宽度
+    int *perm;                  // nchunks * C：排序后的位置 -> 原行号，填充位置为 -1
+    int *col;
+    double *val;
+} sell_t;
+
+typedef struct {
+    int rows, cols;
+    double avg_nnz, skew, norm;
+    uint64_t key;
+} sp_gen_t;
+
+void sp_gen_init(sp_gen_t *g, int rows, int cols, double avg_nnz, double skew, uint64_t key);
+int  sp_gen_row_len(const sp_gen_t *g, int i);
+// 写出第 i 行的 sp_gen_row_len 个列号（升序、互不相同）与 [-1, 1) 内的值
+void sp_gen_row(const sp_gen_t *g, int i, int *col, double *val);
+
+/*
+ * 生成 CSR：row_list 为 NULL 时生成全部行；否则只生成 row_list 中的 nrows 行，
+ * 依次作为局部矩阵的第 0..nrows-1 行（列数不变）。成功返回 0，内存不足返回 -1。
+ */
+int  csr_generate(csr_t *A, const sp_gen_t *g, const int *row_list, int nrows);
+void csr_free(csr_t *A);
+
+// 由 CSR 构造 SELL-C-σ，C 不超过 SELL_MAX_C，sigma 向上取整为 C 的倍数；成功返回 0
+int  sell_from_csr(sell_t *S, const csr_t *A, int C, int sigma);
+void sell_free(sell_t *S);
+
+// bounds[0..nblocks]：bounds[0] = 0，bounds[nblocks] = n，prefix 为 n + 1 项的非降前缀和或 NULL
+void sp_split(const long long *prefix, int n, int nblocks, int *bounds);
+// 第 b 个区间归 b % parts 时，各部分工作量（按 prefix 计）的最大值 / 平均值，1 为完全均衡
+double sp_imbalance(const long long *prefix, const int *bounds, int nblocks, int parts);
+
+// 行 [r0, r1)：y[i] = A(i, :) x
+void csr_spmv(const csr_t *A, const double *x, double *y, int r0, int r1);
+// 行 [r0, r1)：C(i, 0:ncols) = A(i, :) B，B 为 cols x ncols（ldb），C 为 rows x ncols（ldc）
+void csr_spmm(const csr_t *A, const double *B, size_t ldb, int ncols,
+              double *C, size_t ldc, int r0, int r1);
+// 块 [c0, c1)：结果写到原行号的位置，不同块之间可并行
+void sell_spmv(const sell_t *S, const double *x, double *y, int c0, int c1);
+void sell_spmm(const sell_t *S, const double *B, size_t ldb, int ncols,
+               double *C, size_t ldc, int c0, int c1);
+
+#endif
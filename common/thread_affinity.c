@@ -0,0 +1,151 @@
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+#include "thread_affinity.h"
+
+#define AFF_MAX_CPUS 1024
+
+static pthread_once_t aff_once = PTHREAD_ONCE_INIT;
+static int aff_order[AFF_MAX_CPUS];   // 第 t 个线程绑定到 aff_order[t % aff_count]
+static int aff_count = 0;             // 0 表示不绑核
+static const char *aff_name = "false";
+
+#ifdef __linux__
+typedef struct {
+    int cpu, pkg, core_id, smt;
+} aff_cpu_t;
+
+static int read_topology(int cpu, const char *what) {
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, what);
+    FILE *fp = fopen(path, "r");
+    int v = 0;
+    if (fp) {
+        if (fscanf(fp, "%d", &v) != 1) v = 0;
+        fclose(fp);
+    }
+    return v;
+}
+
+static int cmp_compact(const void *x, const void *y) {
+    const aff_cpu_t *a = x, *b = y;
+    if (a->pkg != b->pkg) return a->pkg - b->pkg;
+    if (a->smt != b->smt) return a->smt - b->smt;
+    if (a->core_id != b->core_id) return a->core_id - b->core_id;
+    return a->cpu - b->cpu;
+}
+
+static int cmp_scatter(const void *x, const void *y) {
+    const aff_cpu_t *a = x, *b = y;
+    if (a->smt != b->smt) return a->smt - b->smt;
+    if (a->core_id != b->core_id) return a->core_id - b->core_id;
+    if (a->pkg != b->pkg) return a->pkg - b->pkg;
+    return a->cpu - b->cpu;
+}
+
+// 解析 "0,2,4-7" 形式的 CPU 列表
+static int parse_places(const char *s, int *out, int max) {
+    int n = 0;
+    while (*s && n < max) {
+        char *end;
+        long lo = strtol(s, &end, 10);
+        if (end == s) break;
+        long hi = lo;
+        s = end;
+        if (*s == '-') {
+            hi = strtol(s + 1, &end, 10);
+            s = end;
+        }
+        for (long c = lo; c <= hi && n < max; ++c) out[n++] = (int)c;
+        while (*s == ',' || *s == ' ') ++s;
+    }
+    return n;
+}
+
+static void aff_init(void) {
+    const char *places = getenv("PT_PLACES");
+    if (places && *places) {
+        aff_count = parse_places(places, aff_order, AFF_MAX_CPUS);
+        aff_name = "places";
+        return;
+    }
+    const char *bind = getenv("PT_PROC_BIND");
+    if (!bind || !*bind || strcmp(bind, "false") == 0) return;
+    int scatter = (strcmp(bind, "scatter") == 0 || strcmp(bind, "spread") == 0);
+    aff_name = scatter ? "scatter" : "compact";
+
+    // 只使用进程当前允许运行的 CPU
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return;
+    static aff_cpu_t cpus[AFF_MAX_CPUS];
+    int n = 0;
+    for (int c = 0; c < CPU_SETSIZE && c < AFF_MAX_CPUS; ++c) {
+        if (!CPU_ISSET(c, &allowed)) continue;
+        cpus[n].cpu = c;
+        cpus[n].pkg = read_topology(c, "physical_package_id");
+        cpus[n].core_id = read_topology(c, "core_id");
+        n++;
+    }
+    // smt：同一物理核上的第几个逻辑 CPU；core_id：所在物理核编号
+    for (int i = 0; i < n; ++i) {
+        int smt = 0;
+        for (int j = 0; j < i; ++j)
+            if (cpus[j].pkg == cpus[i].pkg && cpus[j].core_id == cpus[i].core_id) smt++;
+        cpus[i].smt = smt;
+    }
+    qsort(cpus, n, sizeof(aff_cpu_t), scatter ? cmp_scatter : cmp_compact);
+    for (int i = 0; i < n; ++i) aff_order[i] = cpus[i].cpu;
+    aff_count = n;
+}
+#else
+static void aff_init(void) {
+    aff_count = 0;
+}
+#endif
+
+int affinity_cpu_for(int tid) {
+    pthread_once(&aff_once, aff_init);
+    if (aff_count == 0 || tid < 0) return -1;
+    return aff_order[tid % aff_count];
+}
+
+int affinity_bind_self(int tid) {
+    int cpu = affinity_cpu_for(tid);
+#ifdef __linux__
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) return -1;
+    }
+#endif
+    return cpu;
+}
+
+const char *affinity_policy_name(void) {
+    pthread_once(&aff_once, aff_init);
+    return aff_name;
+}
+
+void *affinity_alloc_local(size_t bytes) {
+    if (bytes == 0) bytes = 1;
+    void *p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return NULL;
+    // 由调用线程逐页首次写入，物理页分配在其所在 NUMA 节点
+    long page = sysconf(_SC_PAGESIZE);
+    for (size_t off = 0; off < bytes; off += (size_t)page) ((volatile char *)p)[off] = 0;
+    return p;
+}
+
+void affinity_free_local(void *p, size_t bytes) {
+    if (p) munmap(p, bytes == 0 ? 1 : bytes);
+}
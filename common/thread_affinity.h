@@ -0,0 +1,36 @@
+#ifndef THREAD_AFFINITY_H
+#define THREAD_AFFINITY_H
+
+#include <stddef.h>
+
+/*
+ * 文件：thread_affinity.h
+ * 功能：pthread 程序共用的线程绑核与 NUMA 本地内存分配。
+ *
+ * 绑核策略由环境变量控制（与 OMP_PROC_BIND / OMP_PLACES 类似）：
+ *   PT_PROC_BIND = false   不绑核（默认）
+ *                  compact 相邻线程放在相邻的核上：先填满一个插槽的所有核，再用超线程，再用下一个插槽
+ *                  scatter 相邻线程尽量分散：轮流使用各插槽，先用物理核再用超线程
+ *                  （也接受 OpenMP 的写法 close / spread / true）
+ *   PT_PLACES    = 显式 CPU 列表，如 "0,2,4-7"；设置后第 t 个线程绑定到列表中第 t % n 个 CPU
+ * 仅在 Linux 上生效，其他平台上所有函数为空操作。
+ */
+
+// 第 tid 个线程应绑定的 CPU 编号，不绑核时返回 -1
+int affinity_cpu_for(int tid);
+
+// 把调用线程绑定到第 tid 个线程对应的 CPU，返回 CPU 编号（不绑核返回 -1）
+int affinity_bind_self(int tid);
+
+// 当前策略的文字描述，用于输出
+const char *affinity_policy_name(void);
+
+/*
+ * 为每线程数据分配内存：按页对齐分配，并由调用线程逐页写零完成首次访问，
+ * 在首次访问（first-touch）策略下物理页落在调用线程所在的 NUMA 节点。
+ * 调用线程应当已经绑核。用 affinity_free_local 释放。
+ */
+void *affinity_alloc_local(size_t bytes);
+void affinity_free_local(void *p, size_t bytes);
+
+#endif
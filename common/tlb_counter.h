@@ -0,0 +1,59 @@
+#ifndef TLB_COUNTER_H
+#define TLB_COUNTER_H
+
+/*
+ * 文件：tlb_counter.h
+ * 功能：用 Linux perf_event_open 统计一段代码的 dTLB 读缺失次数，用于比较普通页与大页。
+ *
+ * tlb_counter_start 之后创建的线程继承计数器，线程被 join 之后其计数累加到结果中，
+ * 因此适用于每个用例创建、回收线程的 pthread 程序；常驻线程池（如 OpenMP）中的线程不计入。
+ * 内核不允许（perf_event_paranoid）或非 Linux 平台上 tlb_counter_stop 返回 -1。
+ */
+
+#ifdef __linux__
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+typedef struct {
+    int fd;
+} tlb_counter_t;
+
+static inline void tlb_counter_start(tlb_counter_t *c) {
+    c->fd = -1;
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    c->fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (c->fd < 0) return;
+    ioctl(c->fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(c->fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+}
+
+// 返回 start 以来的 dTLB 读缺失次数，不可用时返回 -1
+static inline long long tlb_counter_stop(tlb_counter_t *c) {
+    long long count = -1;
+#ifdef __linux__
+    if (c->fd < 0) return -1;
+    ioctl(c->fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(c->fd, &count, sizeof(count)) != (ssize_t)sizeof(count)) count = -1;
+    close(c->fd);
+    c->fd = -1;
+#endif
+    return count;
+}
+
+#endif
@@ -0,0 +1,155 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "trace.h"
+
+typedef struct {
+    const char *name;
+    double begin, end;
+    long long n;
+} trace_event_t;
+
+typedef struct {
+    trace_event_t *events;
+    long long count;           // 累计写入的事件数，超过容量后环形覆盖
+} trace_ring_t;
+
+int trace_on = 0;
+
+static int trace_pid = 0;
+static double trace_epoch = 0.0;
+static long long trace_capacity = TRACE_DEFAULT_EVENTS;
+static const char *trace_path = NULL;
+
+// 0 ~ TRACE_MAX_THREADS-1 为工作线程，最后一个槽位为未指定编号的线程（主线程）
+static trace_ring_t trace_rings[TRACE_MAX_THREADS + 1];
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static _Thread_local int trace_tid = TRACE_MAX_THREADS;
+
+static double trace_clock_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec * 1e-3;
+}
+
+void trace_init(int pid) {
+    trace_pid = pid;
+    trace_path = getenv("TRACE");
+    const char *cap = getenv("TRACE_EVENTS");
+    if (cap && atoll(cap) > 0) trace_capacity = atoll(cap);
+    trace_epoch = trace_clock_us();
+    trace_on = (trace_path && trace_path[0]) ? 1 : 0;
+}
+
+void trace_set_thread(int tid) {
+    trace_tid = (tid >= 0 && tid < TRACE_MAX_THREADS) ? tid : TRACE_MAX_THREADS;
+}
+
+double trace_now_us(void) {
+    return trace_clock_us() - trace_epoch;
+}
+
+void trace_record(const char *name, double begin_us, double end_us, long long n) {
+    trace_ring_t *r = &trace_rings[trace_tid];
+    if (!r->events) {
+        pthread_mutex_lock(&trace_lock);
+        if (!r->events) r->events = (trace_event_t *)malloc(sizeof(trace_event_t) * trace_capacity);
+        pthread_mutex_unlock(&trace_lock);
+        if (!r->events) return;
+    }
+    r->events[r->count % trace_capacity] = (trace_event_t){ name, begin_us, end_us, n };
+    r->count++;
+}
+
+// 向动态字符串追加格式化文本
+typedef struct {
+    char *buf;
+    size_t len, cap;
+} trace_str_t;
+
+static void trace_append(trace_str_t *s, const char *fmt, ...) {
+    if (!s->buf) return;
+    for (;;) {
+        va_list ap;
+        va_start(ap, fmt);
+        int w = vsnprintf(s->buf + s->len, s->cap - s->len, fmt, ap);
+        va_end(ap);
+        if (w < 0) return;
+        if (s->len + (size_t)w < s->cap) {
+            s->len += (size_t)w;
+            return;
+        }
+        char *grown = (char *)realloc(s->buf, s->cap * 2 + (size_t)w);
+        if (!grown) {
+            free(s->buf);
+            s->buf = NULL;
+            return;
+        }
+        s->buf = grown;
+        s->cap = s->cap * 2 + (size_t)w;
+    }
+}
+
+char *trace_serialize(size_t *len) {
+    trace_str_t s = { (char *)malloc(4096), 0, 4096 };
+    if (!s.buf) {
+        *len = 0;
+        return NULL;
+    }
+    s.buf[0] = '\0';
+    if (trace_on) {
+        trace_append(&s, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"rank %d\"}},\n",
+                     trace_pid, trace_pid);
+        for (int t = 0; t <= TRACE_MAX_THREADS; ++t) {
+            trace_ring_t *r = &trace_rings[t];
+            if (!r->events || r->count == 0) continue;
+            // 主线程显示为 tid 0，工作线程 t 为 tid t + 1
+            int tid = (t == TRACE_MAX_THREADS) ? 0 : t + 1;
+            if (t == TRACE_MAX_THREADS)
+                trace_append(&s, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"main\"}},\n",
+                             trace_pid);
+            else
+                trace_append(&s, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}},\n",
+                             trace_pid, tid, t);
+            long long first = r->count > trace_capacity ? r->count - trace_capacity : 0;
+            for (long long i = first; i < r->count; ++i) {
+                const trace_event_t *e = &r->events[i % trace_capacity];
+                trace_append(&s, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+                             e->name, trace_pid, tid, e->begin, e->end - e->begin);
+                if (e->n >= 0) trace_append(&s, ",\"args\":{\"n\":%lld}", e->n);
+                trace_append(&s, "},\n");
+            }
+        }
+    }
+    *len = s.buf ? s.len : 0;
+    return s.buf;
+}
+
+int trace_write(const char *events, size_t len) {
+    if (!trace_path || !trace_path[0]) return -1;
+    FILE *fp = fopen(trace_path, "w");
+    if (!fp) {
+        fprintf(stderr, "trace: cannot open %s\n", trace_path);
+        return -1;
+    }
+    // 去掉最后一个事件后的 ",\n"
+    while (len > 0 && (events[len - 1] == '\n' || events[len - 1] == ',')) len--;
+    fputs("{\"traceEvents\":[\n", fp);
+    if (len > 0) fwrite(events, 1, len, fp);
+    fputs("\n],\"displayTimeUnit\":\"ms\"}\n", fp);
+    fclose(fp);
+    return 0;
+}
+
+void trace_dump(void) {
+    if (!trace_on) return;
+    size_t len;
+    char *events = trace_serialize(&len);
+    if (events) {
+        trace_write(events, len);
+        free(events);
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stddef.h>
+
+/*
+ * 文件：trace.h
+ * 功能：轻量的执行时间线记录，导出 Chrome / Perfetto 可直接打开的 trace JSON
+ *       （chrome://tracing 或 ui.perfetto.dev），用于观察各线程、各进程的分发、计算、收集阶段与负载不均衡。
+ *
+ * 环境变量 TRACE=<输出文件> 打开记录，未设置时 trace_begin / trace_end 只检查一个全局标志。
+ * 每个逻辑线程（trace_set_thread 指定的编号，未指定的线程记入 "main"）有自己的环形缓冲区，
+ * 容量为 TRACE_EVENTS 个事件（默认 65536），写满后覆盖最早的事件；同一编号同一时刻只能有一个线程在用。
+ * 事件名必须是字符串常量（只保存指针）。
+ *
+ *     double t0 = trace_begin();
+ *     ...
+ *     trace_end_n("compute", t0, rows);
+ *
+ * MPI 程序：各进程在 MPI_Barrier 之后调用 trace_init(rank)，使时间起点对齐；
+ * 结束时用 trace_serialize 取出本进程的事件，汇总到根进程后由 trace_write 写出一个文件。
+ */
+
+#define TRACE_MAX_THREADS 256
+#define TRACE_DEFAULT_EVENTS 65536
+
+extern int trace_on;
+
+// 读取 TRACE / TRACE_EVENTS，记录时间起点；pid 为进程编号（MPI rank，单进程程序为 0）
+void trace_init(int pid);
+
+// 当前线程的逻辑编号（0 ~ TRACE_MAX_THREADS - 1），线程创建后、记录事件前调用
+void trace_set_thread(int tid);
+
+// 自 trace_init 起的微秒数
+double trace_now_us(void);
+
+// 记录一个 [begin_us, end_us] 的事件；n >= 0 时作为参数 "n" 写入（如行数、块编号）
+void trace_record(const char *name, double begin_us, double end_us, long long n);
+
+static inline double trace_begin(void) {
+    return trace_on ? trace_now_us() : 0.0;
+}
+
+static inline void trace_end(const char *name, double begin_us) {
+    if (trace_on) trace_record(name, begin_us, trace_now_us(), -1);
+}
+
+static inline void trace_end_n(const char *name, double begin_us, long long n) {
+    if (trace_on) trace_record(name, begin_us, trace_now_us(), n);
+}
+
+/*
+ * 本进程的所有事件（含进程名、线程名元数据），每个事件以 ",\n" 结尾，
+ * 多个进程的结果可直接首尾相接后交给 trace_write。返回 malloc 的字符串，记录关闭时为空串。
+ */
+char *trace_serialize(size_t *len);
+
+// 把拼接好的事件写成 {"traceEvents":[...]} 到 TRACE 指定的文件，成功返回 0
+int trace_write(const char *events, size_t len);
+
+// 单进程程序：trace_serialize + trace_write，记录关闭时什么也不做
+void trace_dump(void);
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef XOSHIRO256_H
+#define XOSHIRO256_H
+
+/*
+ * 文件：xoshiro256.h
+ * 功能：多路并行的 xoshiro256+ 随机数生成器。
+ *       状态按 SoA 布局保存 XS_LANES 个独立的生成器，每次调用同时推进所有路，
+ *       循环体只有移位、异或和加法，编译器可以直接向量化（AVX2/NEON）。
+ *
+ * 子流划分：
+ *   - xs_init 之后第 j 路 = 基础序列跳过 j * 2^128 个数（xoshiro 的 jump 函数），各路互不重叠；
+ *   - xs_long_jump 把所有路同时前进 2^192，得到下一个互不重叠的子流，
+ *     第 k 个线程/任务块只需在 xs_init 之后调用 k 次 xs_long_jump。
+ *
+ * 转换为 double 时取高 52 位拼成 [1,2) 的浮点数再减 1，避免整数转浮点指令，便于向量化。
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#ifndef XS_LANES
+#define XS_LANES 8
+#endif
+
+typedef struct {
+    uint64_t s[4][XS_LANES];
+} xs_state_t;
+
+static inline uint64_t xs_rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// 推进所有路一步，out[j] 为第 j 路输出
+static inline void xs_next_lanes(xs_state_t *st, uint64_t out[XS_LANES]) {
+    for (int j = 0; j < XS_LANES; ++j) {
+        uint64_t s0 = st->s[0][j], s1 = st->s[1][j], s2 = st->s[2][j], s3 = st->s[3][j];
+        out[j] = s0 + s3;
+        uint64_t t = s1 << 17;
+        s2 ^= s0;
+        s3 ^= s1;
+        s1 ^= s2;
+        s0 ^= s3;
+        s2 ^= t;
+        s3 = xs_rotl(s3, 45);
+        st->s[0][j] = s0; st->s[1][j] = s1; st->s[2][j] = s2; st->s[3][j] = s3;
+    }
+}
+
+// 把 64 位随机数的高 52 位转换为 [0,1) 区间的 double
+static inline double xs_to_double(uint64_t x) {
+    uint64_t bits = (x >> 12) | 0x3ff0000000000000ULL;
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+    return d - 1.0;
+}
+
+// 推进所有路一步，输出 XS_LANES 个 [0,1) 的 double
+static inline void xs_uniform_lanes(xs_state_t *st, double out[XS_LANES]) {
+    uint64_t u[XS_LANES];
+    xs_next_lanes(st, u);
+    for (int j = 0; j < XS_LANES; ++j) out[j] = xs_to_double(u[j]);
+}
+
+// 生成 n 个 [0,1) 的 double；n 不是 XS_LANES 的倍数时最后一步多余的输出被丢弃
+static inline void xs_uniform_batch(xs_state_t *st, double *out, long long n) {
+    double tmp[XS_LANES];
+    long long i = 0;
+    for (; i + XS_LANES <= n; i += XS_LANES) xs_uniform_lanes(st, out + i);
+    if (i < n) {
+        xs_uniform_lanes(st, tmp);
+        for (int j = 0; i < n; ++i, ++j) out[i] = tmp[j];
+    }
+}
+
+// 对单路状态应用跳跃多项式
+static inline void xs_jump_lane(xs_state_t *st, int lane, const uint64_t poly[4]) {
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for (int i = 0; i < 4; ++i) {
+        for (int b = 0; b < 64; ++b) {
+            if (poly[i] & (1ULL << b)) {
+                s0 ^= st->s[0][lane]; s1 ^= st->s[1][lane];
+                s2 ^= st->s[2][lane]; s3 ^= st->s[3][lane];
+            }
+            // 单独推进这一路
+            uint64_t t = st->s[1][lane] << 17;
+            st->s[2][lane] ^= st->s[0][lane];
+            st->s[3][lane] ^= st->s[1][lane];
+            st->s[1][lane] ^= st->s[2][lane];
+            st->s[0][lane] ^= st->s[3][lane];
+            st->s[2][lane] ^= t;
+            st->s[3][lane] = xs_rotl(st->s[3][lane], 45);
+        }
+    }
+    st->s[0][lane] = s0; st->s[1][lane] = s1; st->s[2][lane] = s2; st->s[3][lane] = s3;
+}
+
+static const uint64_t XS_JUMP[4] = {
+    0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+};
+static const uint64_t XS_LONG_JUMP[4] = {
+    0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL, 0x77710069854ee241ULL, 0x39109bb02acbe635ULL
+};
+
+// 所有路同时前进 2^192，得到下一个子流
+static inline void xs_long_jump(xs_state_t *st) {
+    for (int j = 0; j < XS_LANES; ++j) xs_jump_lane(st, j, XS_LONG_JUMP);
+}
+
+// 由种子初始化：第 0 路用 splitmix64 展开种子，第 j 路为第 j-1 路再跳 2^128
+static inline void xs_init(xs_state_t *st, uint64_t seed) {
+    uint64_t z = seed;
+    for (int i = 0; i < 4; ++i) {
+        z += 0x9e3779b97f4a7c15ULL;
+        uint64_t x = z;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        st->s[i][0] = x ^ (x >> 31);
+    }
+    for (int j = 1; j < XS_LANES; ++j) {
+        for (int i = 0; i < 4; ++i) st->s[i][j] = st->s[i][j - 1];
+        xs_jump_lane(st, j, XS_JUMP);
+    }
+}
+
+#endif
@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "../common/counter_rng.h"
+#include "../common/cache_oblivious.h"
+
+/*
+ * 缓存无关递归矩阵乘法 / 转置与循环实现的对比。
+ * 循环版本即 MultMatrix.cpp 中的 version3_reorder（i-k-j 顺序），
+ * 规模包含非方阵与非 2 的幂，递归版本不设任何分块参数。
+ */
+
+// 获取当前时间（秒）
+static double get_time() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+// 调整循环顺序的三重循环：C += A * B，A 为 m x n，B 为 n x k
+static void matmul_reorder(int m, int n, int k, const double *A, const double *B, double *C) {
+    for (int i = 0; i < m; i++)
+        for (int l = 0; l < n; l++) {
+            double a = A[(size_t)i * n + l];
+            for (int j = 0; j < k; j++)
+                C[(size_t)i * k + j] += a * B[(size_t)l * k + j];
+        }
+}
+
+// 按行读、按列写的朴素转置
+static void transpose_naive(int rows, int cols, const double *A, double *B) {
+    for (int i = 0; i < rows; i++)
+        for (int j = 0; j < cols; j++)
+            B[(size_t)j * rows + i] = A[(size_t)i * cols + j];
+}
+
+int main() {
+    // m x n x k：A 为 m x n，B 为 n x k
+    int shapes[][3] = {
+        {256, 256, 256},
+        {300, 500, 700},
+        {1000, 37, 999},
+        {1023, 1025, 1021},
+        {64, 2000, 64},
+        {1536, 1536, 1536},
+    };
+    int num_shapes = sizeof(shapes) / sizeof(shapes[0]);
+
+    printf("矩阵乘法（GFLOP/s）\n");
+    printf("%6s %6s %6s %12s %12s %12s\n", "m", "n", "k", "循环(i-k-j)", "递归", "最大误差");
+    for (int s = 0; s < num_shapes; s++) {
+        int m = shapes[s][0], n = shapes[s][1], k = shapes[s][2];
+        double *A = (double *)malloc(sizeof(double) * m * n);
+        double *B = (double *)malloc(sizeof(double) * n * k);
+        double *C1 = (double *)calloc((size_t)m * k, sizeof(double));
+        double *C2 = (double *)calloc((size_t)m * k, sizeof(double));
+        if (!A || !B || !C1 || !C2) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            return 1;
+        }
+        crng_fill_uniform(A, 0, (long long)m * n, crng_key(CRNG_DEFAULT_SEED, 0), 0.0, 1.0);
+        crng_fill_uniform(B, 0, (long long)n * k, crng_key(CRNG_DEFAULT_SEED, 1), 0.0, 1.0);
+
+        double t0 = get_time();
+        matmul_reorder(m, n, k, A, B, C1);
+        double t_loop = get_time() - t0;
+
+        t0 = get_time();
+        co_matmul(m, n, k, A, n, B, k, C2, k);
+        double t_rec = get_time() - t0;
+
+        double err = 0.0;
+        for (size_t i = 0; i < (size_t)m * k; i++) {
+            double d = fabs(C1[i] - C2[i]);
+            if (d > err) err = d;
+        }
+        double flops = 2.0 * m * n * k * 1e-9;
+        printf("%6d %6d %6d %12.2f %12.2f %12.2e\n", m, n, k, flops / t_loop, flops / t_rec, err);
+        free(A);
+        free(B);
+        free(C1);
+        free(C2);
+    }
+
+    // 转置：读写各一次，按 16 字节/元素计算带宽
+    int tshapes[][2] = {
+        {1024, 1024},
+        {1000, 3000},
+        {4096, 4096},
+        {5000, 777},
+    };
+    int num_tshapes = sizeof(tshapes) / sizeof(tshapes[0]);
+    printf("\n转置（GB/s）\n");
+    printf("%6s %6s %10s %10s %10s %8s\n", "rows", "cols", "朴素", "递归", "递归原地", "校验");
+    for (int s = 0; s < num_tshapes; s++) {
+        int rows = tshapes[s][0], cols = tshapes[s][1];
+        size_t count = (size_t)rows * cols;
+        double *A = (double *)malloc(sizeof(double) * count);
+        double *B1 = (double *)malloc(sizeof(double) * count);
+        double *B2 = (double *)malloc(sizeof(double) * count);
+        if (!A || !B1 || !B2) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            return 1;
+        }
+        crng_fill_uniform(A, 0, (long long)count, crng_key(CRNG_DEFAULT_SEED, 2), 0.0, 1.0);
+        double gb = 16.0 * count * 1e-9;
+
+        double t0 = get_time();
+        transpose_naive(rows, cols, A, B1);
+        double t_naive = get_time() - t0;
+
+        t0 = get_time();
+        co_transpose(rows, cols, A, cols, B2, rows);
+        double t_rec = get_time() - t0;
+
+        int ok = 1;
+        for (size_t i = 0; i < count; i++)
+            if (B1[i] != B2[i]) { ok = 0; break; }
+
+        // 原地转置只适用于方阵：A 原地转置后应与 B1 相同
+        double t_inplace = -1.0;
+        if (rows == cols) {
+            t0 = get_time();
+            co_transpose_inplace(rows, A, cols);
+            t_inplace = get_time() - t0;
+            for (size_t i = 0; i < count; i++)
+                if (A[i] != B1[i]) { ok = 0; break; }
+        }
+
+        if (t_inplace > 0.0)
+            printf("%6d %6d %10.2f %10.2f %10.2f %8s\n", rows, cols, gb / t_naive, gb / t_rec,
+                   gb / t_inplace, ok ? "PASS" : "FAIL");
+        else
+            printf("%6d %6d %10.2f %10.2f %10s %8s\n", rows, cols, gb / t_naive, gb / t_rec,
+                   "-", ok ? "PASS" : "FAIL");
+        free(A);
+        free(B1);
+        free(B2);
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../common/counter_rng.h"
+#include "../common/small_gemm.hpp"
+
+/*
+ * 批量小矩阵乘法：编译期规模特化（完全展开）与运行时规模通用循环的对比。
+ * 每个数组约 16 MB（超出末级缓存），矩阵连续存放；重复计算整批，使每个规模的总计算量约为 2 GFLOP。
+ */
+
+// 获取当前时间（秒）
+static double get_time() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+int main() {
+    int sizes[] = {4, 8, 12, 16, 20, 24, 28, 32, 7, 13};
+    int num_sizes = sizeof(sizes) / sizeof(sizes[0]);
+    const double total_flop = 2e9;
+    const size_t max_elems = (size_t)1 << 21;
+
+#ifdef _OPENMP
+    printf("OpenMP 线程数: %d\n", omp_get_max_threads());
+#else
+    printf("未开启 OpenMP，批量串行执行\n");
+#endif
+    printf("%6s %10s %6s %12s %12s %8s %12s\n", "n", "batch", "reps", "通用(GF/s)", "特化(GF/s)", "加速比", "最大误差");
+    for (int s = 0; s < num_sizes; s++) {
+        int n = sizes[s];
+        long batch = (long)(max_elems / ((size_t)n * n));
+        size_t count = (size_t)batch * n * n;
+        int reps = (int)(total_flop / (2.0 * n * n * n * batch)) + 1;
+        std::vector<double> A(count), B(count), C1(count), C2(count);
+        crng_fill_uniform(A.data(), 0, (long long)count, crng_key(CRNG_DEFAULT_SEED, 0), -1.0, 1.0);
+        crng_fill_uniform(B.data(), 0, (long long)count, crng_key(CRNG_DEFAULT_SEED, 1), -1.0, 1.0);
+
+        // 先各跑一遍，使页面已分配、代码已预热
+        small_gemm_batch_generic(n, n, n, batch, A.data(), B.data(), C1.data());
+        small_gemm_batched(n, n, n, batch, A.data(), B.data(), C2.data());
+
+        double t0 = get_time();
+        for (int r = 0; r < reps; r++)
+            small_gemm_batch_generic(n, n, n, batch, A.data(), B.data(), C1.data());
+        double t_generic = get_time() - t0;
+
+        int specialized = 0;
+        t0 = get_time();
+        for (int r = 0; r < reps; r++)
+            specialized = small_gemm_batched(n, n, n, batch, A.data(), B.data(), C2.data());
+        double t_special = get_time() - t0;
+
+        double err = 0.0;
+        for (size_t i = 0; i < count; i++) {
+            double d = fabs(C1[i] - C2[i]);
+            if (d > err) err = d;
+        }
+        double gflop = 2.0 * n * n * n * batch * reps * 1e-9;
+        printf("%6d %10ld %6d %12.2f %12.2f %8.2f %12.2e%s\n", n, batch, reps, gflop / t_generic, gflop / t_special,
+               t_generic / t_special, err, specialized ? "" : "  (无特化，通用循环)");
+    }
+    return 0;
+}
@@ -2,10 +2,12 @@
 #include <stdlib.h>
 #include <mpi.h>
 #include <time.h>
+#include "../common/counter_rng.h"
+#include "../common/freivalds.h"
 
 /*
  * 文件：MPIMultMatrix.c
- * 功能：使用 MPI 实现并行矩阵乘法计算。程序读取矩阵尺寸，通过分发矩阵 A 的子块到各个进程，并利用所有进程计算局部矩阵乘法，最终将结果汇总到进程 0 进行输出。
+ * 功能：使用 MPI 实现并行矩阵乘法计算。程序读取矩阵尺寸，各进程按行划分并行生成自己的矩阵 A 子块，并利用所有进程计算局部矩阵乘法，最终将结果汇总到进程 0 进行输出。
  */
 
 void print_matrix(double *mat, int rows, int cols) {
@@ -41,6 +43,8 @@ void matrix_multiply(double *A, double *B, double *C, int rowsA, int colsA, int
 int main(int argc, char *argv[]) {
     int rank, size;
     int m, n, k; // 矩阵 A 为 m×n，矩阵 B 为 n×k，结果矩阵 C 为 m×k
+    unsigned long long seed = CRNG_DEFAULT_SEED; // 随机数种子，相同种子得到相同矩阵
+    int fv_trials; // Freivalds 校验使用的随机向量个数
     int i;
     
     /*
@@ -50,8 +54,8 @@ int main(int argc, char *argv[]) {
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 
-    double *A = NULL;      // 仅在进程0中分配
-    double *B = NULL;      // 所有进程都需要存储完整的 B 矩阵
+    double *A = NULL;      // 仅在进程0中分配，只用于输出
+    double *B = NULL;      // 所有进程都生成完整的 B 矩阵
     double *C = NULL;      // 仅在进程0中分配完整的 C
     double *local_A = NULL; // 每个进程处理自己的 A 子块
     double *local_C = NULL; // 每个进程计算得到的局部 C
@@ -61,24 +65,31 @@ int main(int argc, char *argv[]) {
      */
     if(rank == 0) {
         if(argc < 4) {
-            fprintf(stderr, "Usage: %s m n k\n", argv[0]);
+            fprintf(stderr, "Usage: %s m n k [seed]\n", argv[0]);
             MPI_Abort(MPI_COMM_WORLD, 1);
         }
         m = atoi(argv[1]);
         n = atoi(argv[2]);
         k = atoi(argv[3]);
+        if(argc >= 5)
+            seed = strtoull(argv[4], NULL, 0);
+        fv_trials = fv_trials_for(fv_false_positive_from_env());
     }
-    // 利用 MPI_Send/MPI_Recv 将 m, n, k 传递给所有进程
+    // 利用 MPI_Send/MPI_Recv 将 m, n, k 以及种子、校验向量个数传递给所有进程
     if(rank == 0) {
         for(i = 1; i < size; i++){
             MPI_Send(&m, 1, MPI_INT, i, 0, MPI_COMM_WORLD);
             MPI_Send(&n, 1, MPI_INT, i, 0, MPI_COMM_WORLD);
             MPI_Send(&k, 1, MPI_INT, i, 0, MPI_COMM_WORLD);
+            MPI_Send(&seed, 1, MPI_UNSIGNED_LONG_LONG, i, 0, MPI_COMM_WORLD);
+            MPI_Send(&fv_trials, 1, MPI_INT, i, 0, MPI_COMM_WORLD);
         }
     } else {
         MPI_Recv(&m, 1, MPI_INT, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
         MPI_Recv(&n, 1, MPI_INT, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
         MPI_Recv(&k, 1, MPI_INT, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        MPI_Recv(&seed, 1, MPI_UNSIGNED_LONG_LONG, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        MPI_Recv(&fv_trials, 1, MPI_INT, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
     }
 
     /*
@@ -94,73 +105,37 @@ int main(int argc, char *argv[]) {
         offset = remainder * (rows_per_proc + 1) + (rank - remainder) * rows_per_proc;
 
     /*
-     * 分配内存：进程 0 分配完整的矩阵 A、B、C；其他进程分配矩阵 B 以及各自的 A 子块和局部矩阵 C。
+     * 分配内存：进程 0 额外分配完整的 A（仅用于输出）与 C；所有进程分配完整的 B 以及各自的 A 子块和局部矩阵 C。
      */
     if(rank == 0) {
-        A = (double*) malloc(m * n * sizeof(double));
-        B = (double*) malloc(n * k * sizeof(double));
-        C = (double*) malloc(m * k * sizeof(double));
-        if(A == NULL || B == NULL || C == NULL) {
+        A = (double*) malloc((size_t)m * n * sizeof(double));
+        C = (double*) malloc((size_t)m * k * sizeof(double));
+        if(A == NULL || C == NULL) {
             fprintf(stderr, "内存分配失败\n");
             MPI_Abort(MPI_COMM_WORLD, 1);
         }
-        /*
-         * 进程 0 初始化随机数种子，并随机填充矩阵 A（元素为 0-9 的随机整数）和矩阵 B。
-         */
-        srand(time(NULL));
-        for(i = 0; i < m * n; i++){
-            A[i] = (double)(rand() % 10);  // 随机整数 0-9
-        }
-        for(i = 0; i < n * k; i++){
-            B[i] = (double)(rand() % 10);
-        }
-    } 
-    else {
-        // 其他进程仅需分配 B 的空间
-        B = (double*) malloc(n * k * sizeof(double));
-        if(B == NULL) {
-            fprintf(stderr, "进程 %d 分配 B 内存失败\n", rank);
-            MPI_Abort(MPI_COMM_WORLD, 1);
-        }
     }
-    // 所有进程分配自己 A 子块及局部 C 的内存
-    local_A = (double*) malloc(local_rows * n * sizeof(double));
-    local_C = (double*) malloc(local_rows * k * sizeof(double));
-    if(local_A == NULL || local_C == NULL) {
+    B = (double*) malloc((size_t)n * k * sizeof(double));
+    local_A = (double*) malloc((size_t)local_rows * n * sizeof(double));
+    local_C = (double*) malloc((size_t)local_rows * k * sizeof(double));
+    if(B == NULL || local_A == NULL || local_C == NULL) {
         fprintf(stderr, "进程 %d 分配局部内存失败\n", rank);
         MPI_Abort(MPI_COMM_WORLD, 1);
     }
 
     /*
-     * 进程 0 将 A 的各子块及完整的矩阵 B 分发给其他进程；其他进程接收对应的 A 子块和矩阵 B。
+     * 各进程并行生成数据：使用计数器随机数（元素为 0-9 的随机整数），每个元素只由种子和全局下标决定，
+     * 因此每个进程只填充自己负责的 A 行（全局下标从 offset * n 开始），并各自生成同样的完整 B，
+     * 不需要进程 0 串行生成后再分发，结果与进程数无关。
      */
+    crng_fill_below(local_A, (long long)offset * n, (long long)(offset + local_rows) * n,
+                    crng_key(seed, 0), 10);
+    crng_fill_below(B, 0, (long long)n * k, crng_key(seed, 1), 10);
+
     // 同步所有进程后开始计时
     MPI_Barrier(MPI_COMM_WORLD);
     double start_time = MPI_Wtime();
 
-    if(rank == 0) {
-        // 进程 0 将对应的 A 子块和完整的 B 发送给其他进程
-        for(i = 1; i < size; i++){
-            int proc_rows = (i < remainder) ? rows_per_proc + 1 : rows_per_proc;
-            int proc_offset;
-            if(i < remainder)
-                proc_offset = i * (rows_per_proc + 1);
-            else
-                proc_offset = remainder * (rows_per_proc + 1) + (i - remainder) * rows_per_proc;
-            MPI_Send(&A[proc_offset * n], proc_rows * n, MPI_DOUBLE, i, 1, MPI_COMM_WORLD);
-            MPI_Send(B, n * k, MPI_DOUBLE, i, 2, MPI_COMM_WORLD);
-        }
-        // 进程 0 自己拷贝 A 的第一部分到 local_A
-        for(i = 0; i < local_rows * n; i++){
-            local_A[i] = A[i];
-        }
-    } 
-    else {
-        // 其他进程接收对应的 A 子块和完整矩阵 B
-        MPI_Recv(local_A, local_rows * n, MPI_DOUBLE, 0, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-        MPI_Recv(B, n * k, MPI_DOUBLE, 0, 2, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-    }
-
     /*
      * 每个进程计算自己的局部矩阵乘法：local_C = local_A * B。
      */
@@ -194,6 +169,34 @@ int main(int argc, char *argv[]) {
     double end_time = MPI_Wtime();
     double elapsed_time = end_time - start_time;
 
+    /*
+     * Freivalds 随机校验：各进程用相同的随机向量检查自己的 local_C = local_A * B，
+     * 局部最大归一化残差取 MPI_MAX 归约到进程 0（不超过 1 为通过），无需汇总后重算。
+     */
+    double local_residual = fv_check_rows_f64(local_A, B, local_C, local_rows, n, k, fv_trials, seed);
+    double residual = 0.0;
+    MPI_Reduce(&local_residual, &residual, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    /*
+     * 仅为输出把各进程的 A 子块收集到进程 0（不计入计时）。
+     */
+    if(rank == 0) {
+        for(i = 0; i < local_rows * n; i++){
+            A[i] = local_A[i];
+        }
+        for(i = 1; i < size; i++){
+            int proc_rows = (i < remainder) ? rows_per_proc + 1 : rows_per_proc;
+            int proc_offset;
+            if(i < remainder)
+                proc_offset = i * (rows_per_proc + 1);
+            else
+                proc_offset = remainder * (rows_per_proc + 1) + (i - remainder) * rows_per_proc;
+            MPI_Recv(&A[proc_offset * n], proc_rows * n, MPI_DOUBLE, i, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        }
+    } else {
+        MPI_Send(local_A, local_rows * n, MPI_DOUBLE, 0, 1, MPI_COMM_WORLD);
+    }
+
     /*
      * 进程 0 打印矩阵 A、B、C 以及整个矩阵乘法计算的耗时。
      */
@@ -206,6 +209,8 @@ int main(int argc, char *argv[]) {
         printf("\n矩阵 C (%d x %d):\n", m, k);
         print_matrix(C, m, k);
         printf("\n矩阵乘法计算时间：%f 秒\n", elapsed_time);
+        printf("Freivalds 校验（%d 个随机向量）：最大归一化残差 %.3e，%s\n",
+               fv_trials, residual, (residual >= 0.0 && residual <= 1.0) ? "通过" : "失败");
     }
 
     /*
@@ -2,6 +2,12 @@
 #include <stdlib.h>
 #include <mpi.h>
 #include <time.h>
+#include "../common/counter_rng.h"
+#include "../common/freivalds.h"
+#include "../common/autotune.h"
+#include "../common/trace.h"
+#include "../common/gemm.h"
+#include <string.h>
 
 // 打印矩阵（按行打印，每个元素格式化输出）
 void print_matrix(double *mat, int rows, int cols) {
@@ -15,39 +21,267 @@ void print_matrix(double *mat, int rows, int cols) {
 
 // 矩阵乘法：计算 local_C = local_A * B  
 // local_A 的尺寸为 local_rows×n, B 尺寸 n×k, 结果 local_C 为 local_rows×k
+// 由 common/gemm.c 的完整 GEMM（alpha = 1、beta = 0、行主序、紧密跨度）计算
 void matrix_multiply(double *A, double *B, double *C, int local_rows, int n, int k) {
-    for (int i = 0; i < local_rows; i++){
-        for (int j = 0; j < k; j++){
-            C[i * k + j] = 0.0;
-            for (int l = 0; l < n; l++){
-                C[i * k + j] += A[i * n + l] * B[l * k + j];
-            }
+    gemm_f64(GEMM_ROW_MAJOR, GEMM_NO_TRANS, GEMM_NO_TRANS, local_rows, k, n,
+             1.0, A, n, B, k, 0.0, C, k);
+}
+
+// 由计数器随机数生成 A 的全局行 [r0, r0 + rows)（元素为 0-9 的随机整数）写到 dst，
+// 每个元素只由种子和全局下标决定，各进程只生成自己负责的行即可，无需根进程生成后分发
+static void generate_rows(double *dst, int r0, int rows, int n, unsigned long long seed) {
+    crng_fill_below(dst, (long long)r0 * n, (long long)(r0 + rows) * n, crng_key(seed, 0), 10);
+}
+
+// 块循环划分自动调优：各进程按相同顺序测量同一组候选块大小，
+// 每个候选的耗时取各进程局部计算时间的最大值（MPI_Allreduce），因此所有进程得到相同的搜索结果
+typedef struct {
+    int m, n, k, rank, size;
+    unsigned long long seed;
+    double *B;
+} tune_ctx_t;
+
+static double measure_block_size(const at_config_t *cfg, void *p) {
+    tune_ctx_t *c = (tune_ctx_t*) p;
+    int bs = cfg->v[0];
+    int num_blocks = (c->m + bs - 1) / bs;
+    int rows = 0;
+    for (int j = c->rank; j < num_blocks; j += c->size)
+        rows += ((j + 1) * bs <= c->m) ? bs : (c->m - j * bs);
+    double *A = (double*) malloc((size_t)(rows > 0 ? rows : 1) * c->n * sizeof(double));
+    double *C = (double*) malloc((size_t)(rows > 0 ? rows : 1) * c->k * sizeof(double));
+    // 本进程的 A 行直接由计数器随机数生成，与正式计算时各进程生成的数据相同
+    int idx = 0;
+    for (int j = c->rank; j < num_blocks; j += c->size) {
+        int r0 = j * bs, len = (r0 + bs <= c->m) ? bs : c->m - r0;
+        generate_rows(A + (size_t)idx * c->n, r0, len, c->n, c->seed);
+        idx += len;
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+    double t0 = MPI_Wtime();
+    matrix_multiply(A, c->B, C, rows, c->n, c->k);
+    double local = MPI_Wtime() - t0, slowest;
+    MPI_Allreduce(&local, &slowest, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    free(A);
+    free(C);
+    return slowest;
+}
+
+// 为块循环划分选择块大小：根进程先查缓存，没有则所有进程一起搜索，根进程写入缓存
+static int tune_block_size(int m, int n, int k, int rank, int size, unsigned long long seed, double *B) {
+    static const int candidates[] = {16, 1, 2, 4, 8, 32, 64, 128};
+    const at_param_t params[] = {{ "block_size", candidates, sizeof(candidates) / sizeof(candidates[0]) }};
+    char kernel[64];
+    snprintf(kernel, sizeof(kernel), "mpi_block_cyclic_np%d_n%d_k%d", size, n, k);
+    at_config_t cfg;
+    int state = 0;   // 0：需要搜索，1：已从缓存读取，2：不调优
+    if (rank == 0) {
+        const char *mode = getenv("AUTOTUNE");
+        if (!(mode && strcmp(mode, "force") == 0) && at_load(kernel, m, params, 1, &cfg) == 0)
+            state = 1;
+        else if (mode && strcmp(mode, "off") == 0)
+            state = 2;
+    }
+    MPI_Bcast(&state, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (state == 2) return candidates[0];
+    if (state == 1) {
+        MPI_Bcast(&cfg.v[0], 1, MPI_INT, 0, MPI_COMM_WORLD);
+        return cfg.v[0];
+    }
+    tune_ctx_t ctx = { m, n, k, rank, size, seed, B };
+    double t = at_search(params, 1, measure_block_size, &ctx, &cfg);
+    if (rank == 0) at_store(kernel, m, params, 1, &cfg, t);
+    return cfg.v[0];
+}
+
+// 加权块划分的校准：各进程用真实的 B 计算 CALIB_ROWS 行（取 3 次中最快的一次），
+// 得到每秒可算的行数，经 MPI_Allgather 后所有进程持有相同的速度表
+#define CALIB_ROWS 32
+#define CALIB_REPEATS 3
+
+static void calibrate_rates(int m, int n, int k, unsigned long long seed, double *B, double *rates) {
+    int rows = m < CALIB_ROWS ? m : CALIB_ROWS;
+    if (rows < 1) rows = 1;
+    double *A = (double*) malloc((size_t)rows * n * sizeof(double));
+    double *C = (double*) malloc((size_t)rows * k * sizeof(double));
+    generate_rows(A, 0, rows, n, seed);
+    double best = 1e30;
+    for (int r = 0; r < CALIB_REPEATS; r++) {
+        double t0 = MPI_Wtime();
+        matrix_multiply(A, B, C, rows, n, k);
+        double t = MPI_Wtime() - t0;
+        if (t < best) best = t;
+    }
+    double rate = rows / (best > 1e-9 ? best : 1e-9);
+    MPI_Allgather(&rate, 1, MPI_DOUBLE, rates, 1, MPI_DOUBLE, MPI_COMM_WORLD);
+    free(A);
+    free(C);
+}
+
+// 按速度比例分配 m 行：先取整，余下的行按小数部分从大到小补齐
+static void weighted_counts(int m, int size, const double *rates, int *counts) {
+    double total = 0.0;
+    for (int p = 0; p < size; p++) total += rates[p];
+    double *frac = (double*) malloc(size * sizeof(double));
+    int assigned = 0;
+    for (int p = 0; p < size; p++) {
+        double share = m * rates[p] / total;
+        counts[p] = (int) share;
+        frac[p] = share - counts[p];
+        assigned += counts[p];
+    }
+    for (; assigned < m; assigned++) {
+        int best = 0;
+        for (int p = 1; p < size; p++)
+            if (frac[p] > frac[best]) best = p;
+        counts[best]++;
+        frac[best] = -1.0;
+    }
+    free(frac);
+}
+
+// 动态主从模式：根进程通过 MPI 单边通信公开块计数器与 C，
+// 各进程（含根进程）用 MPI_Fetch_and_op 领取下一个块，自己生成该块的 A 行（计数器随机数），
+// 计算后 MPI_Put 写回根进程的 C。速度在运行中变化的进程自动少领块。
+// 每个块算完后立即做 Freivalds 校验，*residual 为本进程各块的最大归一化残差。
+// 返回本进程计算的行数；*elapsed 只累计各块 matrix_multiply 的耗时（与方法 0-3 的局部时间可比），
+// *comm 为领块（MPI_Fetch_and_op）与写回（MPI_Put + flush）的耗时，生成 A 行与校验都不计入。
+// 只有一个进程时直接计算
+static int multiply_dynamic(double *B, double *C, int m, int n, int k, int block_size,
+                            int rank, int size, unsigned long long seed, int fv_trials,
+                            double *elapsed, double *comm, double *residual) {
+    *comm = 0.0;
+    if (size == 1) {
+        double *A = (double*) malloc((size_t)m * n * sizeof(double));
+        generate_rows(A, 0, m, n, seed);
+        double t0 = MPI_Wtime();
+        matrix_multiply(A, B, C, m, n, k);
+        *elapsed = MPI_Wtime() - t0;
+        *residual = fv_check_rows_f64(A, B, C, m, n, k, fv_trials, seed);
+        free(A);
+        return m;
+    }
+    int next_block = 0;
+    MPI_Win cnt_win, c_win;
+    MPI_Win_create(rank == 0 ? &next_block : NULL, rank == 0 ? sizeof(int) : 0, sizeof(int),
+                   MPI_INFO_NULL, MPI_COMM_WORLD, &cnt_win);
+    MPI_Win_create(rank == 0 ? C : NULL, rank == 0 ? (MPI_Aint)m * k * sizeof(double) : 0, sizeof(double),
+                   MPI_INFO_NULL, MPI_COMM_WORLD, &c_win);
+    double *a_buf = (double*) malloc((size_t)block_size * n * sizeof(double));
+    double *c_buf = (double*) malloc((size_t)block_size * k * sizeof(double));
+    int num_blocks = (m + block_size - 1) / block_size;
+    int rows_done = 0, one = 1, blk;
+    double compute_time = 0.0, comm_time = 0.0;
+    *residual = 0.0;
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    MPI_Win_lock_all(0, cnt_win);
+    MPI_Win_lock_all(0, c_win);
+    for (;;) {
+        double trace_t0 = trace_begin();
+        double tc = MPI_Wtime();
+        MPI_Fetch_and_op(&one, &blk, MPI_INT, 0, 0, MPI_SUM, cnt_win);
+        MPI_Win_flush(0, cnt_win);
+        comm_time += MPI_Wtime() - tc;
+        if (blk >= num_blocks) break;
+        int r0 = blk * block_size;
+        int rows = (r0 + block_size <= m) ? block_size : m - r0;
+        generate_rows(a_buf, r0, rows, n, seed);
+        trace_end_n("generate", trace_t0, blk);
+
+        trace_t0 = trace_begin();
+        double tm = MPI_Wtime();
+        matrix_multiply(a_buf, B, c_buf, rows, n, k);
+        compute_time += MPI_Wtime() - tm;
+        trace_end_n("compute", trace_t0, rows);
+
+        trace_t0 = trace_begin();
+        tc = MPI_Wtime();
+        MPI_Put(c_buf, rows * k, MPI_DOUBLE, 0, (MPI_Aint)r0 * k, rows * k, MPI_DOUBLE, c_win);
+        MPI_Win_flush(0, c_win);
+        comm_time += MPI_Wtime() - tc;
+        trace_end_n("put", trace_t0, blk);
+
+        double r = fv_check_rows_f64(a_buf, B, c_buf, rows, n, k, fv_trials, seed);
+        if (*residual >= 0.0 && (r < 0.0 || r > *residual)) *residual = r;  // -1（内存不足）保持到最后
+        rows_done += rows;
+    }
+    MPI_Win_unlock_all(c_win);
+    MPI_Win_unlock_all(cnt_win);
+    *elapsed = compute_time;
+    *comm = comm_time;
+
+    // 释放窗口是集合操作，返回后根进程的 C 已包含所有进程写入的块
+    MPI_Win_free(&c_win);
+    MPI_Win_free(&cnt_win);
+    free(a_buf);
+    free(c_buf);
+    return rows_done;
+}
+
+// 各进程的时间线事件汇总到根进程，写成一个 trace 文件（TRACE 未设置时各进程只发送长度 0）
+static void dump_trace(int rank, int size) {
+    size_t len = 0;
+    char *events = trace_on ? trace_serialize(&len) : NULL;
+    int my_len = (int)len;
+    int *lens = NULL, *displs = NULL;
+    char *all = NULL;
+    if (rank == 0) {
+        lens = (int*) malloc(size * sizeof(int));
+        displs = (int*) malloc(size * sizeof(int));
+    }
+    MPI_Gather(&my_len, 1, MPI_INT, lens, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    int total = 0;
+    if (rank == 0) {
+        for (int p = 0; p < size; p++) {
+            displs[p] = total;
+            total += lens[p];
         }
+        all = (char*) malloc(total > 0 ? total : 1);
     }
+    MPI_Gatherv(events, my_len, MPI_CHAR, all, lens, displs, MPI_CHAR, 0, MPI_COMM_WORLD);
+    if (rank == 0 && total > 0 && trace_write(all, total) == 0)
+        printf("时间线已写入 %s\n", getenv("TRACE"));
+    free(events);
+    free(all);
+    free(lens);
+    free(displs);
 }
 
 int main(int argc, char *argv[]){
     int rank, size;
     int m, n, k;       // A: m×n, B: n×k, C: m×k
-    int method;        // 0: 块划分, 1: 循环划分, 2: 块循环划分
-    int block_size = 16; // 仅对方法2有效，默认块大小
+    int method;        // 0: 块划分, 1: 循环划分, 2: 块循环划分, 3: 按实测速度加权的块划分, 4: 动态主从（单边通信领块）
+    int block_size = 0;  // 对方法2、4有效，0 表示方法2自动调优（读取缓存或现场搜索）、方法4取默认块大小
+    unsigned long long seed = CRNG_DEFAULT_SEED; // 随机数种子，相同种子得到相同矩阵
+    int fv_trials = 1; // Freivalds 校验使用的随机向量个数
 
     MPI_Init(&argc, &argv);
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
+    // 同步后记录时间起点，各进程的时间线对齐
+    MPI_Barrier(MPI_COMM_WORLD);
+    trace_init(rank);
 
     // 根进程解析命令行参数
     if (rank == 0) {
         if (argc < 4) {
-            fprintf(stderr, "Usage: %s m n k [method] [block_size]\n", argv[0]);
+            fprintf(stderr, "Usage: %s m n k [method 0-4] [block_size] [seed]\n", argv[0]);
             MPI_Abort(MPI_COMM_WORLD, 1);
         }
         m = atoi(argv[1]);
         n = atoi(argv[2]);
         k = atoi(argv[3]);
         method = (argc >= 5) ? atoi(argv[4]) : 0;
-        if (method == 2) {
-            block_size = (argc >= 6) ? atoi(argv[5]) : 16;
+        if (method == 2 || method == 4) {
+            block_size = (argc >= 6) ? atoi(argv[5]) : 0;
+        }
+        if (argc >= 7)
+            seed = strtoull(argv[6], NULL, 0);
+        fv_trials = fv_trials_for(fv_false_positive_from_env());
+        if (method < 0 || method > 4) {
+            fprintf(stderr, "Error: method must be 0-4, got %d\n", method);
+            MPI_Abort(MPI_COMM_WORLD, 1);
         }
     }
     // 广播 m, n, k, method 以及（对块循环）block_size到所有进程
@@ -55,25 +289,52 @@ int main(int argc, char *argv[]){
     MPI_Bcast(&n, 1, MPI_INT, 0, MPI_COMM_WORLD);
     MPI_Bcast(&k, 1, MPI_INT, 0, MPI_COMM_WORLD);
     MPI_Bcast(&method, 1, MPI_INT, 0, MPI_COMM_WORLD);
-    if(method == 2)
+    if(method == 2 || method == 4)
         MPI_Bcast(&block_size, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&seed, 1, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&fv_trials, 1, MPI_INT, 0, MPI_COMM_WORLD);
 
     // 所有进程分配 B（全矩阵B每个进程均需保存）
     double *B = (double*) malloc(n * k * sizeof(double));
-    // 矩阵 A 和 C 仅在根进程中分配
-    double *A = NULL;
+    // 结果矩阵 C 仅在根进程中分配；A 不再整体存在，各进程只生成自己负责的行
     double *C = NULL;
+    double trace_t0 = trace_begin();
     if (rank == 0) {
-        A = (double*) malloc(m * n * sizeof(double));
-        C = (double*) malloc(m * k * sizeof(double));
-        srand(time(NULL));
-        for (int i = 0; i < m * n; i++)
-            A[i] = (double)(rand() % 10);
-        for (int i = 0; i < n * k; i++)
-            B[i] = (double)(rand() % 10);
+        C = (double*) malloc((size_t)m * k * sizeof(double));
+    }
+    // B 由计数器随机数生成，各进程用相同种子各自生成即可得到完全相同的 B，无需广播
+    crng_fill_below(B, 0, (long long)n * k, crng_key(seed, 1), 10);
+    trace_end("generate", trace_t0);
+
+    if (method == 2 && block_size <= 0) {
+        trace_t0 = trace_begin();
+        block_size = tune_block_size(m, n, k, rank, size, seed, B);
+        trace_end_n("tune", trace_t0, block_size);
+        if (rank == 0)
+            printf("自动调优块大小：%d（CPU：%s）\n", block_size, at_cpu_model());
+    }
+    // 动态模式默认每个进程约领 8 个块
+    if (method == 4 && block_size <= 0) {
+        block_size = m / (size * 8);
+        if (block_size < 1) block_size = 1;
+    }
+
+    // 加权块划分：校准各进程速度，按比例确定每个进程的连续行数（所有进程得到相同结果）
+    int *weighted_rows = NULL;
+    if (method == 3) {
+        double *rates = (double*) malloc(size * sizeof(double));
+        weighted_rows = (int*) malloc(size * sizeof(int));
+        trace_t0 = trace_begin();
+        calibrate_rates(m, n, k, seed, B, rates);
+        weighted_counts(m, size, rates, weighted_rows);
+        trace_end("calibrate", trace_t0);
+        if (rank == 0) {
+            printf("校准速度（行/秒）与分配行数：\n");
+            for (int p = 0; p < size; p++)
+                printf("进程 %d: %.1f, %d 行\n", p, rates[p], weighted_rows[p]);
+        }
+        free(rates);
     }
-    // 广播 B 到所有进程
-    MPI_Bcast(B, n * k, MPI_DOUBLE, 0, MPI_COMM_WORLD);
 
     // 根据不同划分方式计算每个进程将获得的 A 的行数 local_rows
     int local_rows = 0;
@@ -95,120 +356,81 @@ int main(int argc, char *argv[]){
                 local_rows += rows_in_block;
             }
         }
+    } else if (method == 3) { // 加权块划分
+        local_rows = weighted_rows[rank];
     }
+    // 动态模式不预先分配行，各进程领到块后再生成该块的 A 行
     // 分配本地 A 和本地结果 C
-    double *local_A = (double*) malloc(local_rows * n * sizeof(double));
-    double *local_C = (double*) malloc(local_rows * k * sizeof(double));
+    double *local_A = (double*) malloc((size_t)local_rows * n * sizeof(double));
+    double *local_C = (double*) malloc((size_t)local_rows * k * sizeof(double));
 
-    /* 数据分发：将全局矩阵 A 按不同方式分发到各进程 */
+    /* 数据生成：各进程按划分方式直接生成自己负责的 A 行（依次放入 local_A），
+       与根进程生成整个 A 后分发得到的数据完全相同，但生成是并行的，也省去了分发 */
+    trace_t0 = trace_begin();
 
     if (method == 0) {
-        // —— 块划分：利用 MPI_Scatterv 实现连续行分发
-        int *sendcounts = (int*) malloc(size * sizeof(int));
-        int *displs = (int*) malloc(size * sizeof(int));
+        // —— 块划分：连续的 local_rows 行，起点为前面各进程的行数之和
         int rows_per_proc = m / size;
         int remainder = m % size;
-        for (int i = 0; i < size; i++) {
-            sendcounts[i] = (i < remainder ? rows_per_proc + 1 : rows_per_proc) * n;
-        }
-        displs[0] = 0;
-        for (int i = 1; i < size; i++) {
-            displs[i] = displs[i - 1] + sendcounts[i - 1];
-        }
-        MPI_Scatterv(A, sendcounts, displs, MPI_DOUBLE,
-                     local_A, sendcounts[rank], MPI_DOUBLE, 0, MPI_COMM_WORLD);
-        free(sendcounts);
-        free(displs);
+        int offset = rank * rows_per_proc + (rank < remainder ? rank : remainder);
+        generate_rows(local_A, offset, local_rows, n, seed);
     } else if (method == 1) {
-        // —— 循环划分：根进程按行下标 i % size 分发
-        if (rank == 0) {
-            int idx = 0;
-            // 根进程复制属于自己的行
-            for (int i = 0; i < m; i++) {
-                if (i % size == 0) {
-                    for (int j = 0; j < n; j++)
-                        local_A[idx * n + j] = A[i * n + j];
-                    idx++;
-                }
-            }
-            // 对于其他进程，打包并发送其所有行
-            for (int p = 1; p < size; p++) {
-                int count = 0;
-                for (int i = 0; i < m; i++) {
-                    if (i % size == p)
-                        count++;
-                }
-                double *temp = (double*) malloc(count * n * sizeof(double));
-                int t = 0;
-                for (int i = 0; i < m; i++) {
-                    if (i % size == p) {
-                        for (int j = 0; j < n; j++)
-                            temp[t * n + j] = A[i * n + j];
-                        t++;
-                    }
-                }
-                MPI_Send(temp, count * n, MPI_DOUBLE, p, 1, MPI_COMM_WORLD);
-                free(temp);
-            }
-        } else {
-            MPI_Recv(local_A, local_rows * n, MPI_DOUBLE, 0, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-        }
+        // —— 循环划分：第 i 行归 i % size
+        for (int i = rank, idx = 0; i < m; i += size, idx++)
+            generate_rows(local_A + (size_t)idx * n, i, 1, n, seed);
     } else if (method == 2) {
-        // —— 块循环划分：先按块（每块 block_size 行）划分，再循环分配
+        // —— 块循环划分：第 j 块（每块 block_size 行）归 j % size
         int num_blocks = (m + block_size - 1) / block_size;
-        if (rank == 0) {
-            int idx = 0;
-            for (int j = 0; j < num_blocks; j++) {
-                if (j % size == 0) {
-                    int start_row = j * block_size;
-                    int rows_in_block = ((start_row + block_size) <= m) ? block_size : (m - start_row);
-                    for (int i = 0; i < rows_in_block; i++) {
-                        for (int j2 = 0; j2 < n; j2++) {
-                            local_A[idx * n + j2] = A[(start_row + i) * n + j2];
-                        }
-                        idx++;
-                    }
-                }
-            }
-            for (int p = 1; p < size; p++) {
-                int count = 0;
-                for (int j = 0; j < num_blocks; j++) {
-                    if (j % size == p) {
-                        int start_row = j * block_size;
-                        int rows_in_block = ((start_row + block_size) <= m) ? block_size : (m - start_row);
-                        count += rows_in_block;
-                    }
-                }
-                double *temp = (double*) malloc(count * n * sizeof(double));
-                int idx2 = 0;
-                for (int j = 0; j < num_blocks; j++) {
-                    if (j % size == p) {
-                        int start_row = j * block_size;
-                        int rows_in_block = ((start_row + block_size) <= m) ? block_size : (m - start_row);
-                        for (int i = 0; i < rows_in_block; i++) {
-                            for (int j2 = 0; j2 < n; j2++) {
-                                temp[idx2 * n + j2] = A[(start_row + i) * n + j2];
-                            }
-                            idx2++;
-                        }
-                    }
-                }
-                MPI_Send(temp, count * n, MPI_DOUBLE, p, 1, MPI_COMM_WORLD);
-                free(temp);
-            }
-        } else {
-            MPI_Recv(local_A, local_rows * n, MPI_DOUBLE, 0, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        int idx = 0;
+        for (int j = rank; j < num_blocks; j += size) {
+            int start_row = j * block_size;
+            int rows_in_block = ((start_row + block_size) <= m) ? block_size : (m - start_row);
+            generate_rows(local_A + (size_t)idx * n, start_row, rows_in_block, n, seed);
+            idx += rows_in_block;
         }
+    } else if (method == 3) {
+        // —— 加权块划分：连续行数与实测速度成正比
+        int offset = 0;
+        for (int p = 0; p < rank; p++) offset += weighted_rows[p];
+        generate_rows(local_A, offset, local_rows, n, seed);
     }
 
-    // 同步后计时，开始局部矩阵乘法计算
-    MPI_Barrier(MPI_COMM_WORLD);
-    double t_start = MPI_Wtime();
-    matrix_multiply(local_A, B, local_C, local_rows, n, k);
-    double t_end = MPI_Wtime();
-    double local_time = t_end - t_start;
+    trace_end_n("generate", trace_t0, local_rows);
+
+    double local_time, local_comm = 0.0, local_residual = 0.0;
+    if (method == 4) {
+        // —— 动态主从：生成、计算、收集、校验都在领块循环中完成
+        local_rows = multiply_dynamic(B, C, m, n, k, block_size, rank, size, seed, fv_trials,
+                                      &local_time, &local_comm, &local_residual);
+    } else {
+        // 同步后计时，开始局部矩阵乘法计算
+        trace_t0 = trace_begin();
+        MPI_Barrier(MPI_COMM_WORLD);
+        trace_end("barrier", trace_t0);
+        double t_start = MPI_Wtime();
+        trace_t0 = trace_begin();
+        matrix_multiply(local_A, B, local_C, local_rows, n, k);
+        trace_end_n("compute", trace_t0, local_rows);
+        double t_end = MPI_Wtime();
+        local_time = t_end - t_start;
+    }
+
+    /* Freivalds 随机校验：各种划分都是按行分配且各进程持有完整 B，
+       各进程检查自己的行，局部最大归一化残差用 MPI_MAX 归约到根进程；
+       动态模式下各进程已在领块循环中检查了自己算的块 */
+    trace_t0 = trace_begin();
+    if (method != 4)
+        local_residual = fv_check_rows_f64(local_A, B, local_C, local_rows, n, k, fv_trials, seed);
+    double residual = 0.0;
+    MPI_Reduce(&local_residual, &residual, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    trace_end_n("verify", trace_t0, local_rows);
+    if (rank == 0) {
+        printf("Freivalds 校验（%d 个随机向量）：最大归一化残差 %.3e，%s\n",
+               fv_trials, residual, (residual >= 0.0 && residual <= 1.0) ? "通过" : "失败");
+    }
 
     /* 结果收集：将各进程计算得到的局部矩阵 C（尺寸 local_rows×k）汇总成全局矩阵 C */
+    trace_t0 = trace_begin();
     if (method == 0) {
         // —— 块划分：利用 MPI_Gatherv 收集
         int *recvcounts = (int*) malloc(size * sizeof(int));
@@ -310,22 +532,53 @@ int main(int argc, char *argv[]){
         } else {
             MPI_Send(local_C, local_rows * k, MPI_DOUBLE, 0, 2, MPI_COMM_WORLD);
         }
+    } else if (method == 3) {
+        // —— 加权块划分：按各进程的行数 MPI_Gatherv 收集
+        int *recvcounts = (int*) malloc(size * sizeof(int));
+        int *rdispls = (int*) malloc(size * sizeof(int));
+        for (int i = 0; i < size; i++) {
+            recvcounts[i] = weighted_rows[i] * k;
+        }
+        rdispls[0] = 0;
+        for (int i = 1; i < size; i++) {
+            rdispls[i] = rdispls[i - 1] + recvcounts[i - 1];
+        }
+        MPI_Gatherv(local_C, recvcounts[rank], MPI_DOUBLE,
+                    C, recvcounts, rdispls, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+        free(recvcounts);
+        free(rdispls);
     }
 
-    double *all_times = NULL;
+    trace_end_n("gather", trace_t0, local_rows);
+
+    double *all_times = NULL, *all_comm = NULL;
+    int *all_rows = NULL;
     if (rank == 0) {
         all_times = (double*) malloc(size * sizeof(double));
+        all_comm = (double*) malloc(size * sizeof(double));
+        all_rows = (int*) malloc(size * sizeof(int));
         all_times[0] = local_time;
+        all_comm[0] = local_comm;
+        all_rows[0] = local_rows;
         for (int p = 1; p < size; p++){
             MPI_Recv(&all_times[p], 1, MPI_DOUBLE, p, 3, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            MPI_Recv(&all_rows[p], 1, MPI_INT, p, 4, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            MPI_Recv(&all_comm[p], 1, MPI_DOUBLE, p, 5, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
         }
         printf("各进程局部计算时间（秒）：\n");
         for (int p = 0; p < size; p++){
-            printf("进程 %d: %f\n", p, all_times[p]);
+            if (method == 4)
+                printf("进程 %d: %f（%d 行，领块与写回通信 %f 秒）\n", p, all_times[p], all_rows[p], all_comm[p]);
+            else
+                printf("进程 %d: %f（%d 行）\n", p, all_times[p], all_rows[p]);
         }
         free(all_times);
+        free(all_comm);
+        free(all_rows);
     } else {
         MPI_Send(&local_time, 1, MPI_DOUBLE, 0, 3, MPI_COMM_WORLD);
+        MPI_Send(&local_rows, 1, MPI_INT, 0, 4, MPI_COMM_WORLD);
+        MPI_Send(&local_comm, 1, MPI_DOUBLE, 0, 5, MPI_COMM_WORLD);
     }
 
     if (rank == 0) {
@@ -333,11 +586,13 @@ int main(int argc, char *argv[]){
         print_matrix(C, m, k);
     }
 
+    dump_trace(rank, size);
+
     free(B);
     free(local_A);
     free(local_C);
+    free(weighted_rows);
     if (rank == 0) {
-        free(A);
         free(C);
     }
     MPI_Finalize();
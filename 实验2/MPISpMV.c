@@ -0,0 +1,235 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <mpi.h>
+#include "../common/counter_rng.h"
+#include "../common/sparse.h"
+
+#define CYCLIC_BLOCKS 16    // 按非零元均衡的循环划分中每个进程的块数
+#define MIN_TIME 0.05       // 每个核重复执行至少这么长时间（秒），取平均
+
+// 第 rank 个进程拥有的行：第 rank、rank + size、... 个区间，依次排列
+static int owned_rows(const int *bounds, int nblocks, int rank, int size, int *list) {
+    int n = 0;
+    for (int b = rank; b < nblocks; b += size)
+        for (int i = bounds[b]; i < bounds[b + 1]; i++) list[n++] = i;
+    return n;
+}
+
+// 局部 SpMV / SpMM 的平均耗时（秒）
+static double time_kernel(const csr_t *A, const sell_t *S, int use_sell, int spmm,
+                          const double *x, double *y, const double *B, double *C, int ncols) {
+    int reps = 0;
+    double t0 = MPI_Wtime(), t1;
+    do {
+        if (use_sell) {
+            if (spmm) sell_spmm(S, B, ncols, ncols, C, ncols, 0, S->nchunks);
+            else sell_spmv(S, x, y, 0, S->nchunks);
+        } else {
+            if (spmm) csr_spmm(A, B, ncols, ncols, C, ncols, 0, A->rows);
+            else csr_spmv(A, x, y, 0, A->rows);
+        }
+        reps++;
+        t1 = MPI_Wtime();
+    } while (t1 - t0 < MIN_TIME);
+    return (t1 - t0) / reps;
+}
+
+// 根进程：把按进程顺序收集的局部结果（每行 width 个数）放回原行号
+static void scatter_rows(const double *gathered, double *out, int width,
+                         const int *bounds, int nblocks, int size, int *list) {
+    long long pos = 0;
+    for (int p = 0; p < size; p++) {
+        int n = owned_rows(bounds, nblocks, p, size, list);
+        for (int i = 0; i < n; i++, pos++)
+            memcpy(out + (size_t)list[i] * width, gathered + (size_t)pos * width, sizeof(double) * width);
+    }
+}
+
+// max |out - ref| / max |ref|
+static double rel_error(const double *out, const double *ref, long long n) {
+    double err = 0.0, scale = 0.0;
+    for (long long i = 0; i < n; i++) {
+        double d = fabs(out[i] - ref[i]);
+        if (!(d <= err)) err = d;
+        if (fabs(ref[i]) > scale) scale = fabs(ref[i]);
+    }
+    return err / (scale > 0.0 ? scale : 1.0);
+}
+
+int main(int argc, char *argv[]) {
+    int rank, size;
+    int rows;            // A 为 rows x rows 的稀疏方阵
+    double avg, skew;    // 每行平均非零元个数、行长偏斜度（0 为各行相近）
+    int method;          // 0: 等行数块划分, 1: 等行数循环划分, 2: 按非零元均衡的块划分, 3: 按非零元均衡的块循环划分
+    int use_sell = 0;    // 0: CSR, 1: SELL-C-σ
+    int ncols = 16;      // SpMM 中稠密矩阵 B 的列数
+    unsigned long long seed = CRNG_DEFAULT_SEED;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    // 根进程解析命令行参数
+    if (rank == 0) {
+        if (argc < 5) {
+            fprintf(stderr, "Usage: %s rows avg_nnz skew method(0-3) [format 0=CSR 1=SELL] [spmm_cols] [seed]\n", argv[0]);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        rows = atoi(argv[1]);
+        avg = atof(argv[2]);
+        skew = atof(argv[3]);
+        method = atoi(argv[4]);
+        if (argc >= 6) use_sell = atoi(argv[5]);
+        if (argc >= 7) ncols = atoi(argv[6]);
+        if (argc >= 8) seed = strtoull(argv[7], NULL, 0);
+        if (use_sell != 0 && use_sell != 1) {
+            fprintf(stderr, "Error: format must be 0 (CSR) or 1 (SELL), got %d\n", use_sell);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        if (method < 0 || method > 3) {
+            fprintf(stderr, "Error: method must be 0-3, got %d\n", method);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+    }
+    MPI_Bcast(&rows, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&avg, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&skew, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&method, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&use_sell, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&ncols, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&seed, 1, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+
+    // 行长只由 (种子, 行号) 决定，各进程各自算出全部行长的前缀和，得到相同的划分，无需通信
+    sp_gen_t gen;
+    sp_gen_init(&gen, rows, rows, avg, skew, crng_key(seed, 0));
+    long long *prefix = (long long*) malloc(sizeof(long long) * (rows + 1));
+    prefix[0] = 0;
+    for (int i = 0; i < rows; i++) prefix[i + 1] = prefix[i] + sp_gen_row_len(&gen, i);
+
+    // 等行数的循环划分与 MPIMultMatrixV2 相同：第 i 行归 i % size
+    int nblocks = (method == 1) ? rows : (method == 3) ? size * CYCLIC_BLOCKS : size;
+    int *bounds = (int*) malloc(sizeof(int) * (nblocks + 1));
+    sp_split(method >= 2 ? prefix : NULL, rows, nblocks, bounds);
+    double imbal = sp_imbalance(prefix, bounds, nblocks, size);
+
+    // 各进程只生成自己的行；x 与 B 由计数器随机数生成，各进程用相同种子各自生成完整副本
+    int *list = (int*) malloc(sizeof(int) * (rows > 0 ? rows : 1));
+    int local_rows = owned_rows(bounds, nblocks, rank, size, list);
+    csr_t A;
+    sell_t S;
+    memset(&S, 0, sizeof(S));
+    if (csr_generate(&A, &gen, list, local_rows) != 0 ||
+        (use_sell && sell_from_csr(&S, &A, SELL_DEFAULT_C, SELL_DEFAULT_SIGMA) != 0)) {
+        fprintf(stderr, "进程 %d 内存不足\n", rank);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    double *x = (double*) malloc(sizeof(double) * rows);
+    double *B = (double*) malloc(sizeof(double) * (size_t)rows * ncols);
+    double *local_y = (double*) malloc(sizeof(double) * (local_rows > 0 ? local_rows : 1));
+    double *local_C = (double*) malloc(sizeof(double) * ((size_t)local_rows * ncols > 0 ? (size_t)local_rows * ncols : 1));
+    crng_fill_uniform(x, 0, rows, crng_key(seed, 1), -1.0, 1.0);
+    crng_fill_uniform(B, 0, (long long)rows * ncols, crng_key(seed, 2), -1.0, 1.0);
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    double t_spmv = time_kernel(&A, &S, use_sell, 0, x, local_y, B, local_C, ncols);
+    double t_spmm = time_kernel(&A, &S, use_sell, 1, x, local_y, B, local_C, ncols);
+
+    // 收集各进程的行数、非零元与耗时
+    long long local_nnz = A.nnz;
+    int *all_rows = NULL;
+    long long *all_nnz = NULL;
+    double *all_spmv = NULL, *all_spmm = NULL;
+    if (rank == 0) {
+        all_rows = (int*) malloc(size * sizeof(int));
+        all_nnz = (long long*) malloc(size * sizeof(long long));
+        all_spmv = (double*) malloc(size * sizeof(double));
+        all_spmm = (double*) malloc(size * sizeof(double));
+    }
+    MPI_Gather(&local_rows, 1, MPI_INT, all_rows, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Gather(&local_nnz, 1, MPI_LONG_LONG, all_nnz, 1, MPI_LONG_LONG, 0, MPI_COMM_WORLD);
+    MPI_Gather(&t_spmv, 1, MPI_DOUBLE, all_spmv, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    MPI_Gather(&t_spmm, 1, MPI_DOUBLE, all_spmm, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+    // 根进程收集 y 与 C（按进程顺序），再按各进程的行号放回
+    int *counts = NULL, *displs = NULL;
+    double *gathered = NULL, *y = NULL, *C = NULL;
+    if (rank == 0) {
+        counts = (int*) malloc(size * sizeof(int));
+        displs = (int*) malloc(size * sizeof(int));
+        gathered = (double*) malloc(sizeof(double) * (size_t)rows * ncols);
+        y = (double*) malloc(sizeof(double) * rows);
+        C = (double*) malloc(sizeof(double) * (size_t)rows * ncols);
+        for (int p = 0; p < size; p++) {
+            counts[p] = all_rows[p];
+            displs[p] = p == 0 ? 0 : displs[p - 1] + counts[p - 1];
+        }
+    }
+    MPI_Gatherv(local_y, local_rows, MPI_DOUBLE, gathered, counts, displs, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    if (rank == 0) {
+        scatter_rows(gathered, y, 1, bounds, nblocks, size, list);
+        for (int p = 0; p < size; p++) {
+            counts[p] = all_rows[p] * ncols;
+            displs[p] = p == 0 ? 0 : displs[p - 1] + counts[p - 1];
+        }
+    }
+    MPI_Gatherv(local_C, local_rows * ncols, MPI_DOUBLE, gathered, counts, displs, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        scatter_rows(gathered, C, ncols, bounds, nblocks, size, list);
+        static const char *method_names[] = {"等行数块划分", "等行数循环划分", "非零元均衡块划分", "非零元均衡块循环划分"};
+        printf("rows=%d, nnz=%lld, skew=%.2f, 格式 %s, 划分 %s（%d 个区间）\n", rows, prefix[rows], skew,
+               use_sell ? "SELL-C-σ" : "CSR", method_names[method], nblocks);
+        printf("非零元不均衡度（最大/平均）：%.2f\n", imbal);
+        printf("各进程局部计算时间（秒）：\n");
+        double max_spmv = 0.0, max_spmm = 0.0, sum_spmv = 0.0;
+        for (int p = 0; p < size; p++) {
+            printf("进程 %d: SpMV %f，SpMM %f（%d 行，%lld 个非零元）\n",
+                   p, all_spmv[p], all_spmm[p], all_rows[p], all_nnz[p]);
+            if (all_spmv[p] > max_spmv) max_spmv = all_spmv[p];
+            if (all_spmm[p] > max_spmm) max_spmm = all_spmm[p];
+            sum_spmv += all_spmv[p];
+        }
+        printf("SpMV：%f 秒（最慢进程），%.2f GFLOP/s，时间不均衡度 %.2f\n", max_spmv,
+               2.0 * prefix[rows] / max_spmv * 1e-9, max_spmv * size / sum_spmv);
+        printf("SpMM（%d 列）：%f 秒（最慢进程），%.2f GFLOP/s\n", ncols, max_spmm,
+               2.0 * prefix[rows] * ncols / max_spmm * 1e-9);
+
+        // 根进程生成完整矩阵串行计算参考结果
+        csr_t full;
+        if (csr_generate(&full, &gen, NULL, 0) == 0) {
+            double *y_ref = (double*) malloc(sizeof(double) * rows);
+            double *C_ref = (double*) malloc(sizeof(double) * (size_t)rows * ncols);
+            csr_spmv(&full, x, y_ref, 0, rows);
+            csr_spmm(&full, B, ncols, ncols, C_ref, ncols, 0, rows);
+            double err_y = rel_error(y, y_ref, rows), err_C = rel_error(C, C_ref, (long long)rows * ncols);
+            printf("与串行结果比较：SpMV 最大相对误差 %.2e，SpMM %.2e，%s\n", err_y, err_C,
+                   (err_y < 1e-12 && err_C < 1e-12) ? "PASS" : "FAIL");
+            free(y_ref);
+            free(C_ref);
+            csr_free(&full);
+        }
+        free(counts);
+        free(displs);
+        free(gathered);
+        free(y);
+        free(C);
+        free(all_rows);
+        free(all_nnz);
+        free(all_spmv);
+        free(all_spmm);
+    }
+
+    free(local_C);
+    free(local_y);
+    free(B);
+    free(x);
+    sell_free(&S);
+    csr_free(&A);
+    free(list);
+    free(bounds);
+    free(prefix);
+    MPI_Finalize();
+    return 0;
+}
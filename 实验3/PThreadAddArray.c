@@ -1,75 +1,282 @@
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include <sys/time.h>
 #include <time.h>
+#include "../common/counter_rng.h"
+#include "../common/thread_affinity.h"
+#include "../common/parallel_reduce.h"
 
-typedef struct {
-    int start;          // 当前线程处理起始下标
-    int end;            // 当前线程处理结束下标
-    long long partial_sum;  // 当前线程计算的局部和
-} thread_arg_t;
+#define MAX_THREADS 16
 
 int *array;   // 全局数组指针
+uint64_t seed;           // 随机数种子（环境变量 RNG_SEED 覆盖）
+
+// 首次访问初始化：pr_for 的第 tid 块 [begin, end) 由绑核后的第 tid 个线程写入随机数（0-9），
+// 物理页落在该线程所在的 NUMA 节点；pr_sum_i32 对同一 (n, 线程数) 使用相同的划分与绑核
+static void first_touch_block(void *ctx, int tid, long long begin, long long end) {
+    (void)ctx;
+    (void)tid;
+    uint64_t key = crng_key(seed, 0);
+    for (long long i = begin; i < end; i++) {
+        array[i] = (int)crng_below(key, (uint64_t)i, 10);
+    }
+}
+
+// STREAM Triad 参考带宽测试：线程常驻，各自首次访问自己的区间后在屏障之间计时
+#define TRIAD_REPS 5
+
+typedef struct {
+    double *a, *b, *c;
+    long long n;
+    int num_threads;
+    pthread_barrier_t barrier;
+    struct timeval start;
+    double best;        // 最好一次的带宽（GB/s），由线程 0 写入
+} triad_shared_t;
+
+typedef struct {
+    triad_shared_t *sh;
+    int tid;
+} triad_arg_t;
+
+void* triad_worker(void* arg) {
+    triad_arg_t *t = (triad_arg_t*) arg;
+    triad_shared_t *sh = t->sh;
+    affinity_bind_self(t->tid);
+    long long begin = sh->n * t->tid / sh->num_threads, end = sh->n * (t->tid + 1) / sh->num_threads;
+    // 首次访问：本线程负责的页落在它所在的 NUMA 节点，与计时循环中访问的区间相同
+    for (long long i = begin; i < end; i++) { sh->a[i] = 0.0; sh->b[i] = 1.0; sh->c[i] = 2.0; }
+    for (int rep = 0; rep < TRIAD_REPS; rep++) {
+        pthread_barrier_wait(&sh->barrier);
+        if (t->tid == 0) gettimeofday(&sh->start, NULL);
+        pthread_barrier_wait(&sh->barrier);
+        for (long long i = begin; i < end; i++) {
+            sh->a[i] = sh->b[i] + 3.0 * sh->c[i];
+        }
+        pthread_barrier_wait(&sh->barrier);
+        if (t->tid == 0) {
+            struct timeval stop;
+            gettimeofday(&stop, NULL);
+            double sec = (stop.tv_sec - sh->start.tv_sec) + (stop.tv_usec - sh->start.tv_usec) * 1e-6;
+            double gbs = 3.0 * sizeof(double) * sh->n / sec / 1e9;
+            if (gbs > sh->best) sh->best = gbs;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * 用 STREAM Triad 测量本机可达内存带宽（GB/s）。
+ * 数组由各线程并行首次访问初始化，计时只包含屏障之间的 Triad 循环，不含线程创建与回收。
+ * 若已用官方 STREAM 测过，可通过环境变量 STREAM_BW=<GB/s> 直接给出。
+ */
+double stream_bandwidth(int num_threads) {
+    const char *env = getenv("STREAM_BW");
+    if (env && *env) return atof(env);
+
+    triad_shared_t sh;
+    sh.n = 1LL << 23;   // 3 个数组共 192 MB，远大于末级缓存
+    sh.a = malloc(sizeof(double) * sh.n);
+    sh.b = malloc(sizeof(double) * sh.n);
+    sh.c = malloc(sizeof(double) * sh.n);
+    sh.num_threads = num_threads;
+    sh.best = 0.0;
+    pthread_barrier_init(&sh.barrier, NULL, num_threads);
+    pthread_t threads[MAX_THREADS];
+    triad_arg_t args[MAX_THREADS];
+    for (int t = 0; t < num_threads; t++) {
+        args[t] = (triad_arg_t){&sh, t};
+        pthread_create(&threads[t], NULL, triad_worker, &args[t]);
+    }
+    for (int t = 0; t < num_threads; t++) pthread_join(threads[t], NULL);
+    pthread_barrier_destroy(&sh.barrier);
+    free(sh.a); free(sh.b); free(sh.c);
+    return sh.best;
+}
+
+/* ---------------- 流式（外存）模式 ---------------- */
+
+#define STREAM_CHUNK_MB 64   // 默认每块 64 MB
 
-// 线程入口函数：计算局部和，不涉及共享变量的写操作
-void* parallel_sum_without_mutex(void* arg) {
-    thread_arg_t *targ = (thread_arg_t*) arg;
-    long long sum = 0;
-    for (int i = targ->start; i < targ->end; i++) {
-        sum += array[i];
+// 读线程参数：从文件 offset 处读取 bytes 字节到 buf
+typedef struct {
+    int fd;
+    int *buf;
+    off_t offset;
+    size_t bytes;
+    ssize_t got;        // 实际读到的字节数，出错为 -1
+} reader_arg_t;
+
+// 读线程：循环 pread 直到读满或到达文件末尾
+void* chunk_reader(void* arg) {
+    reader_arg_t *r = (reader_arg_t*) arg;
+    size_t done = 0;
+    while (done < r->bytes) {
+        ssize_t n = pread(r->fd, (char*)r->buf + done, r->bytes - done, r->offset + (off_t)done);
+        if (n < 0) { r->got = -1; return NULL; }
+        if (n == 0) break;
+        done += (size_t)n;
     }
-    targ->partial_sum = sum;
+    r->got = (ssize_t)done;
     return NULL;
 }
 
-int main() {
+/*
+ * 对二进制 int32 文件做流式求和，文件可以远大于内存。
+ * 双缓冲：读线程把第 k+1 块读入一个缓冲区的同时，求和线程处理另一个缓冲区中的第 k 块，
+ * I/O 与计算重叠；内存占用只有两个块。
+ */
+int stream_sum_file(const char *path, int num_threads, long long chunk_mb) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        perror(path);
+        close(fd);
+        return 1;
+    }
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);   // 提示内核加大预读
+#endif
+    size_t chunk_bytes = (size_t)chunk_mb << 20;
+    int *buf[2];
+    if (posix_memalign((void**)&buf[0], 4096, chunk_bytes) != 0 ||
+        posix_memalign((void**)&buf[1], 4096, chunk_bytes) != 0) {
+        fprintf(stderr, "内存分配失败\n");
+        close(fd);
+        return 1;
+    }
+
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+
+    reader_arg_t rd[2];
+    pthread_t reader;
+    rd[0] = (reader_arg_t){fd, buf[0], 0, chunk_bytes, 0};
+    chunk_reader(&rd[0]);                     // 第一块同步读取
+
+    long long total = 0, elements = 0;
+    off_t offset = (off_t)rd[0].got;
+    int cur = 0, err = (rd[0].got < 0);
+    while (!err && rd[cur].got > 0) {
+        int next = 1 - cur;
+        rd[next] = (reader_arg_t){fd, buf[next], offset, chunk_bytes, 0};
+        pthread_create(&reader, NULL, chunk_reader, &rd[next]);   // 预读下一块
+
+        long long count = rd[cur].got / (ssize_t)sizeof(int);
+        total += pr_sum_i32(buf[cur], count, num_threads);
+        elements += count;
+
+        pthread_join(reader, NULL);
+        if (rd[next].got < 0) err = 1;
+        else offset += (off_t)rd[next].got;
+        cur = next;
+    }
+
+    gettimeofday(&end, NULL);
+    double sec = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) * 1e-6;
+    if (err) perror("pread");
+    else
+        printf("文件: %s, 元素数: %lld, 线程数: %d, 块大小: %lld MB, 求和结果: %lld, 耗时: %.3f s, 吞吐: %.2f GB/s\n",
+               path, elements, num_threads, chunk_mb, total, sec, (double)offset / sec / 1e9);
+    if (st.st_size % (off_t)sizeof(int) != 0)
+        fprintf(stderr, "警告：文件大小不是 %zu 的整数倍，末尾字节被忽略\n", sizeof(int));
+
+    free(buf[0]);
+    free(buf[1]);
+    close(fd);
+    return err;
+}
+
+// 生成 count 个 0-9 随机 int32 写入文件，供流式模式测试
+int generate_file(const char *path, long long count) {
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        perror(path);
+        return 1;
+    }
+    const long long block = 1 << 20;
+    int *buf = malloc(sizeof(int) * block);
+    uint64_t key = crng_key(seed, 0);
+    for (long long i = 0; i < count; i += block) {
+        long long n = (count - i < block) ? count - i : block;
+        for (long long j = 0; j < n; j++) buf[j] = (int)crng_below(key, (uint64_t)(i + j), 10);
+        fwrite(buf, sizeof(int), (size_t)n, fp);
+    }
+    free(buf);
+    fclose(fp);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    seed = crng_seed_from_env(CRNG_DEFAULT_SEED);
+    if (argc >= 2 && strcmp(argv[1], "--gen") == 0) {
+        if (argc < 4) {
+            fprintf(stderr, "Usage: %s --gen file count\n", argv[0]);
+            return 1;
+        }
+        return generate_file(argv[2], atoll(argv[3]));
+    }
+    if (argc >= 2) {
+        int num_threads = (argc >= 3) ? atoi(argv[2]) : 4;
+        long long chunk_mb = (argc >= 4) ? atoll(argv[3]) : STREAM_CHUNK_MB;
+        if (num_threads < 1 || num_threads > MAX_THREADS || chunk_mb < 1) {
+            fprintf(stderr, "Usage: %s [file [threads(1-%d)] [chunk_MB]] | --gen file count\n", argv[0], MAX_THREADS);
+            return 1;
+        }
+        return stream_sum_file(argv[1], num_threads, chunk_mb);
+    }
+
     int sizes[8] = {1000000, 2000000, 4000000, 8000000, 16000000,32000000,64000000,128000000};
     int thread_nums[5] = {1, 2, 4, 8, 16};
-    srand(time(NULL));
+
+    double stream_bw = stream_bandwidth(MAX_THREADS);
+    printf("STREAM Triad 参考带宽: %.2f GB/s, 绑核策略: %s\n", stream_bw, affinity_policy_name());
 
     for (int i = 0; i < 8; i++) {
         int array_size = sizes[i];
-        // Allocate memory for the array and initialize with random numbers (0-9)
-        array = (int*)malloc(sizeof(int) * array_size);
-        for (int j = 0; j < array_size; j++) {
-            array[j] = rand() % 10;
-        }
         printf("----- 数组规模: %d -----\n", array_size);
 
         // Loop over different thread counts
         for (int k = 0; k < 5; k++) {
             int num_threads = thread_nums[k];
-            pthread_t threads[num_threads];
-            thread_arg_t thread_args[num_threads];
-            int chunk = array_size / num_threads;
+
+            // Allocate memory for the array; pages are not touched yet
+            if (posix_memalign((void**)&array, 64, sizeof(int) * (size_t)array_size) != 0) {
+                fprintf(stderr, "内存分配失败\n");
+                return 1;
+            }
+
+            // Parallel first-touch initialization with random numbers (0-9):
+            // pr_for uses the same partition and thread binding as pr_sum_i32 below,
+            // so each thread sums the pages it touched, on its own NUMA node
+            pr_for(array_size, num_threads, first_touch_block, NULL);
 
             struct timeval start, end;
             gettimeofday(&start, NULL);
 
-            // Create threads; each thread processes its subarray
-            for (int t = 0; t < num_threads; t++) {
-                thread_args[t].start = t * chunk;
-                thread_args[t].end = (t == num_threads - 1) ? array_size : (t + 1) * chunk;
-                thread_args[t].partial_sum = 0;
-                pthread_create(&threads[t], NULL, parallel_sum_without_mutex, &thread_args[t]);
-            }
-
-            // Wait for threads to finish and aggregate results
-            long long sum_result = 0;
-            for (int t = 0; t < num_threads; t++) {
-                pthread_join(threads[t], NULL);
-                sum_result += thread_args[t].partial_sum;
-            }
+            // Widened SIMD sum over contiguous per-thread blocks (common/parallel_reduce.c)
+            long long sum_result = pr_sum_i32(array, array_size, num_threads);
 
             gettimeofday(&end, NULL);
             double time_spent = (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_usec - start.tv_usec);
             time_spent /= 1000;  // Convert microseconds to milliseconds
 
-            printf("线程数: %d, 求和结果: %lld, 耗时: %.3f ms\n", num_threads, sum_result, time_spent);
-        }
+            double gbs = sizeof(int) * (double)array_size / (time_spent * 1e-3) / 1e9;
+            printf("线程数: %d, 求和结果: %lld, 耗时: %.3f ms, 带宽: %.2f GB/s (%.1f%% STREAM)\n",
+                   num_threads, sum_result, time_spent, gbs, 100.0 * gbs / stream_bw);
 
-        free(array);
+            free(array);
+        }
     }
     return 0;
 }
\ No newline at end of file
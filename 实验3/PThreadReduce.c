@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "../common/counter_rng.h"
+#include "../common/thread_affinity.h"
+#include "../common/parallel_reduce.h"
+
+/*
+ * 文件：PThreadReduce.c
+ * 功能：common/parallel_reduce.c 的校验与计时程序。对 int、float、double 数组，
+ *       把求和、最小/最大值、inclusive/exclusive 前缀和（float、double 另测原地扫描）与直方图
+ *       的并行结果和串行结果比较，并输出各线程数下的耗时；有任何一项不通过时返回 1。
+ *
+ * 比较标准：int 与直方图必须完全相同；float / double 的求和与前缀和按累加顺序不同带来的舍入误差，
+ *   误差除以 sum |a| 后 float 不超过 1e-6、double 不超过 1e-12 视为通过。
+ */
+
+#define NBINS 32
+
+static int failures = 0;
+
+// 获取当前时间（秒）
+static double get_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+static void report(const char *type, const char *op, int threads, long long n, double err, double tol, double sec) {
+    int ok = err <= tol;
+    if (!ok) failures++;
+    printf("%s, %s, %d, %lld, %.3e, %.3f, %s\n", type, op, threads, n, err, sec * 1e3, ok ? "通过" : "失败");
+}
+
+/*
+ * 每种类型的校验：T 为元素类型，SCAN_T 为前缀和输出类型，SUFFIX 为库函数后缀，TOL 为相对误差上界。
+ * 串行参考一律在 long double 中顺序累加，整数类型的误差为 0 才通过。
+ */
+#define DEFINE_CHECK(SUFFIX, T, SCAN_T, TOL, NAME)                                          \
+static void check_##SUFFIX(const T *a, long long n, int threads, SCAN_T *out, T *copy) {   \
+    long double run = 0.0L, abs_sum = 0.0L;                                                 \
+    T mn = a[0], mx = a[0];                                                                 \
+    for (long long i = 0; i < n; i++) {                                                     \
+        run += a[i];                                                                        \
+        abs_sum += a[i] < 0 ? -(long double)a[i] : (long double)a[i];                       \
+        if (a[i] < mn) mn = a[i];                                                           \
+        if (a[i] > mx) mx = a[i];                                                           \
+    }                                                                                       \
+    const double scale = abs_sum > 0.0L ? (double)abs_sum : 1.0;                            \
+    double t0 = get_time();                                                                 \
+    double sum = (double)pr_sum_##SUFFIX(a, n, threads);                                    \
+    report(NAME, "sum", threads, n, fabs(sum - (double)run) / scale, TOL, get_time() - t0); \
+    t0 = get_time();                                                                        \
+    T got_min = pr_min_##SUFFIX(a, n, threads);                                             \
+    report(NAME, "min", threads, n, got_min == mn ? 0.0 : 1.0, 0.0, get_time() - t0);       \
+    t0 = get_time();                                                                        \
+    T got_max = pr_max_##SUFFIX(a, n, threads);                                             \
+    report(NAME, "max", threads, n, got_max == mx ? 0.0 : 1.0, 0.0, get_time() - t0);       \
+    for (int inclusive = 1; inclusive >= 0; inclusive--) {                                  \
+        t0 = get_time();                                                                    \
+        if (inclusive) pr_inclusive_scan_##SUFFIX(a, out, n, threads);                      \
+        else           pr_exclusive_scan_##SUFFIX(a, out, n, threads);                      \
+        double sec = get_time() - t0, err = 0.0;                                            \
+        long double r = 0.0L;                                                               \
+        for (long long i = 0; i < n; i++) {                                                 \
+            if (!inclusive) { double d = fabs((double)out[i] - (double)r); if (d > err) err = d; } \
+            r += a[i];                                                                      \
+            if (inclusive)  { double d = fabs((double)out[i] - (double)r); if (d > err) err = d; } \
+        }                                                                                   \
+        report(NAME, inclusive ? "inclusive_scan" : "exclusive_scan", threads, n,           \
+               err / scale, TOL, sec);                                                      \
+    }                                                                                       \
+    long long counts[NBINS], ref[NBINS] = {0};                                              \
+    const double lo = (double)mn, hi = (double)mx + 1.0;                                    \
+    for (long long i = 0; i < n; i++) {                                                     \
+        int bin = (int)(((double)a[i] - lo) * (NBINS / (hi - lo)));                         \
+        ref[bin < NBINS ? bin : NBINS - 1]++;                                               \
+    }                                                                                       \
+    t0 = get_time();                                                                        \
+    pr_histogram_##SUFFIX(a, n, lo, hi, NBINS, counts, threads);                            \
+    double sec = get_time() - t0;                                                           \
+    report(NAME, "histogram", threads, n, memcmp(counts, ref, sizeof(ref)) == 0 ? 0.0 : 1.0, \
+           0.0, sec);                                                                       \
+    if (copy) {                                                                             \
+        /* 原地扫描：out 与 in 为同一数组 */                                               \
+        for (int inclusive = 1; inclusive >= 0; inclusive--) {                              \
+            memcpy(copy, a, sizeof(T) * (size_t)n);                                         \
+            t0 = get_time();                                                                \
+            if (inclusive) pr_inclusive_scan_##SUFFIX(copy, (SCAN_T *)copy, n, threads);    \
+            else           pr_exclusive_scan_##SUFFIX(copy, (SCAN_T *)copy, n, threads);    \
+            double sec2 = get_time() - t0, err = 0.0;                                       \
+            long double r = 0.0L;                                                           \
+            for (long long i = 0; i < n; i++) {                                             \
+                if (!inclusive) { double d = fabs((double)copy[i] - (double)r); if (d > err) err = d; } \
+                r += a[i];                                                                  \
+                if (inclusive)  { double d = fabs((double)copy[i] - (double)r); if (d > err) err = d; } \
+            }                                                                               \
+            report(NAME, inclusive ? "inclusive_scan(in-place)" : "exclusive_scan(in-place)", \
+                   threads, n, err / scale, TOL, sec2);                                     \
+        }                                                                                   \
+    }                                                                                       \
+}
+
+DEFINE_CHECK(i32, int,    long long, 0.0,   "int")
+DEFINE_CHECK(f32, float,  float,     1e-6,  "float")
+DEFINE_CHECK(f64, double, double,    1e-12, "double")
+
+int main(int argc, char **argv) {
+    // 参数：最大数组长度；另外总会测试 1 个元素与不足以启用多线程的小数组
+    long long max_n = argc > 1 ? atoll(argv[1]) : 4000003;
+    long long sizes[] = {1, 1000, max_n};
+    int thread_options[] = {1, 2, 4, 8, 16};
+    int num_thread_options = sizeof(thread_options) / sizeof(thread_options[0]);
+    if (max_n < 1) {
+        fprintf(stderr, "Usage: %s [max_n >= 1]\n", argv[0]);
+        return 1;
+    }
+
+    uint64_t seed = crng_seed_from_env(CRNG_DEFAULT_SEED);
+    int *ai = malloc(sizeof(int) * (size_t)max_n);
+    float *af = malloc(sizeof(float) * (size_t)max_n);
+    double *ad = malloc(sizeof(double) * (size_t)max_n);
+    long long *outi = malloc(sizeof(long long) * (size_t)max_n);
+    float *outf = malloc(sizeof(float) * (size_t)max_n);
+    double *outd = malloc(sizeof(double) * (size_t)max_n);
+    float *copyf = malloc(sizeof(float) * (size_t)max_n);
+    double *copyd = malloc(sizeof(double) * (size_t)max_n);
+    if (!ai || !af || !ad || !outi || !outf || !outd || !copyf || !copyd) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return 1;
+    }
+    // int 含负数以检查 min / 直方图下界；浮点为 [-1, 1) 的均匀分布
+    uint64_t key = crng_key(seed, 0);
+    for (long long i = 0; i < max_n; i++) {
+        ai[i] = (int)crng_below(key, (uint64_t)i, 2001) - 1000;
+        ad[i] = 2.0 * crng_uniform(key, (uint64_t)i) - 1.0;
+        af[i] = (float)ad[i];
+    }
+
+    printf("绑核策略: %s\n", affinity_policy_name());
+    printf("Type, Op, Threads, N, Error, Time(ms), Result\n");
+    for (int s = 0; s < 3; s++) {
+        long long n = sizes[s] < max_n ? sizes[s] : max_n;
+        for (int t = 0; t < num_thread_options; t++) {
+            check_i32(ai, n, thread_options[t], outi, NULL);
+            check_f32(af, n, thread_options[t], outf, copyf);
+            check_f64(ad, n, thread_options[t], outd, copyd);
+        }
+    }
+    printf("%s：%d 项不通过\n", failures ? "失败" : "全部通过", failures);
+
+    free(ai); free(af); free(ad);
+    free(outi); free(outf); free(outd);
+    free(copyf); free(copyd);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include "../common/thread_affinity.h"
+#include "../common/counter_rng.h"
+#include "../common/sparse.h"
+
+/*
+ * 稀疏矩阵（common/sparse.c）的 pthread 并行 SpMV（y = A x）与 SpMM（C = A B，B 为少量列的稠密矩阵），
+ * 比较 CSR 与 SELL-C-σ 两种格式，以及三种划分：
+ *   rows-block  按行数等分为连续块（原有的块划分）
+ *   nnz-block   按非零元个数等分为连续块
+ *   nnz-cyclic  按非零元个数切成 线程数 x BLOCKS_PER_THREAD 块，第 b 块归 b % 线程数
+ */
+
+#define BLOCKS_PER_THREAD 8     // 循环划分中每个线程的块数
+#define MIN_TIME 0.05           // 每个用例重复执行至少这么长时间（秒），取平均
+
+typedef struct {
+    csr_t A;
+    sell_t S;
+    int ncols;
+    double *x, *y, *B, *C;
+} problem_t;
+
+// 一个用例：线程常驻，用两个屏障分隔每次重复，由最后到达的线程计时并决定是否继续
+typedef struct {
+    const problem_t *pr;
+    int sell, spmm;
+    const int *bounds;
+    int nblocks, threads;
+    pthread_barrier_t start, done;
+    int more, reps;
+    double t0, elapsed;
+} case_t;
+
+typedef struct {
+    case_t *c;
+    int tid;
+} worker_t;
+
+// 获取当前时间（秒）
+static double get_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+// 计算一个块：CSR 为行区间，SELL 为块（chunk）区间
+static void run_block(const problem_t *pr, int sell, int spmm, int lo, int hi) {
+    if (!sell) {
+        if (spmm) csr_spmm(&pr->A, pr->B, pr->ncols, pr->ncols, pr->C, pr->ncols, lo, hi);
+        else csr_spmv(&pr->A, pr->x, pr->y, lo, hi);
+    } else {
+        if (spmm) sell_spmm(&pr->S, pr->B, pr->ncols, pr->ncols, pr->C, pr->ncols, lo, hi);
+        else sell_spmv(&pr->S, pr->x, pr->y, lo, hi);
+    }
+}
+
+// 线程函数：第 tid 个线程计算第 tid、tid + threads、... 块
+static void *worker(void *arg) {
+    worker_t *w = (worker_t *)arg;
+    case_t *c = w->c;
+    affinity_bind_self(w->tid);
+    for (;;) {
+        if (pthread_barrier_wait(&c->start) == PTHREAD_BARRIER_SERIAL_THREAD && c->reps == 0)
+            c->t0 = get_time();
+        if (!c->more) break;
+        for (int b = w->tid; b < c->nblocks; b += c->threads)
+            run_block(c->pr, c->sell, c->spmm, c->bounds[b], c->bounds[b + 1]);
+        if (pthread_barrier_wait(&c->done) == PTHREAD_BARRIER_SERIAL_THREAD) {
+            c->reps++;
+            c->elapsed = get_time() - c->t0;
+            c->more = c->elapsed < MIN_TIME;
+        }
+    }
+    return NULL;
+}
+
+// 返回每次调用的平均时间（秒）
+static double time_case(const problem_t *pr, int sell, int spmm, const int *bounds, int nblocks, int threads) {
+    case_t c = {.pr = pr, .sell = sell, .spmm = spmm, .bounds = bounds, .nblocks = nblocks,
+                .threads = threads, .more = 1};
+    pthread_barrier_init(&c.start, NULL, threads);
+    pthread_barrier_init(&c.done, NULL, threads);
+    pthread_t tid[threads];
+    worker_t w[threads];
+    for (int i = 0; i < threads; i++) {
+        w[i].c = &c;
+        w[i].tid = i;
+        pthread_create(&tid[i], NULL, worker, &w[i]);
+    }
+    for (int i = 0; i < threads; i++) pthread_join(tid[i], NULL);
+    pthread_barrier_destroy(&c.start);
+    pthread_barrier_destroy(&c.done);
+    return c.elapsed / c.reps;
+}
+
+// max |out - ref| / max |ref|
+static double rel_error(const double *out, const double *ref, long long n) {
+    double err = 0.0, scale = 0.0;
+    for (long long i = 0; i < n; i++) {
+        double d = fabs(out[i] - ref[i]);
+        if (!(d <= err)) err = d;
+        if (fabs(ref[i]) > scale) scale = fabs(ref[i]);
+    }
+    return err / (scale > 0.0 ? scale : 1.0);
+}
+
+int main(int argc, char **argv) {
+    // 参数：行数（= 列数）、每行平均非零元、行长偏斜度、SpMM 的列数
+    int rows = argc > 1 ? atoi(argv[1]) : 200000;
+    double avg = argc > 2 ? atof(argv[2]) : 16.0;
+    double skew = argc > 3 ? atof(argv[3]) : 0.5;
+    int ncols = argc > 4 ? atoi(argv[4]) : 16;
+    int thread_options[] = {1, 2, 4, 8, 16};
+    int num_thread_options = sizeof(thread_options) / sizeof(thread_options[0]);
+    const char *split_names[] = {"rows-block", "nnz-block", "nnz-cyclic"};
+    int max_blocks = thread_options[num_thread_options - 1] * BLOCKS_PER_THREAD;
+
+    uint64_t seed = crng_seed_from_env(CRNG_DEFAULT_SEED);
+    sp_gen_t gen;
+    sp_gen_init(&gen, rows, rows, avg, skew, crng_key(seed, 0));
+
+    problem_t pr;
+    pr.ncols = ncols;
+    if (csr_generate(&pr.A, &gen, NULL, 0) != 0 ||
+        sell_from_csr(&pr.S, &pr.A, SELL_DEFAULT_C, SELL_DEFAULT_SIGMA) != 0) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return -1;
+    }
+    pr.x = malloc(sizeof(double) * rows);
+    pr.y = malloc(sizeof(double) * rows);
+    pr.B = malloc(sizeof(double) * (size_t)rows * ncols);
+    pr.C = malloc(sizeof(double) * (size_t)rows * ncols);
+    double *y_ref = malloc(sizeof(double) * rows);
+    double *C_ref = malloc(sizeof(double) * (size_t)rows * ncols);
+    int *bounds = malloc(sizeof(int) * (max_blocks + 1));
+    if (!pr.x || !pr.y || !pr.B || !pr.C || !y_ref || !C_ref || !bounds) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return -1;
+    }
+    crng_fill_uniform(pr.x, 0, rows, crng_key(seed, 1), -1.0, 1.0);
+    crng_fill_uniform(pr.B, 0, (long long)rows * ncols, crng_key(seed, 2), -1.0, 1.0);
+
+    // 串行 CSR 结果作为所有并行用例的参考
+    csr_spmv(&pr.A, pr.x, y_ref, 0, rows);
+    csr_spmm(&pr.A, pr.B, ncols, ncols, C_ref, ncols, 0, rows);
+
+    long long nnz = pr.A.nnz, stored = pr.S.chunk_ptr[pr.S.nchunks];
+    printf("绑核策略: %s\n", affinity_policy_name());
+    printf("rows=%d, nnz=%lld, skew=%.2f, SpMM columns=%d, SELL-%d-%d 填充后 %lld 个位置（非零元占 %.1f%%）\n",
+           rows, nnz, skew, ncols, pr.S.C, pr.S.sigma, stored, 100.0 * nnz / (stored > 0 ? stored : 1));
+    // Imbalance 为最重线程的非零元（SELL 为含填充的位置数）与平均值之比
+    printf("Op, Format, Split, Threads, Imbalance, Time(s), GFLOP/s, Error\n");
+
+    for (int spmm = 0; spmm <= 1; spmm++) {
+        double flop = 2.0 * nnz * (spmm ? ncols : 1);
+        for (int sell = 0; sell <= 1; sell++) {
+            int n = sell ? pr.S.nchunks : rows;
+            const long long *prefix = sell ? pr.S.chunk_ptr : pr.A.row_ptr;
+            for (int s = 0; s < 3; s++) {
+                for (int t = 0; t < num_thread_options; t++) {
+                    int threads = thread_options[t];
+                    int nblocks = s == 2 ? threads * BLOCKS_PER_THREAD : threads;
+                    sp_split(s == 0 ? NULL : prefix, n, nblocks, bounds);
+                    double imbal = sp_imbalance(prefix, bounds, nblocks, threads);
+
+                    memset(spmm ? pr.C : pr.y, 0, sizeof(double) * (size_t)rows * (spmm ? ncols : 1));
+                    double elapsed = time_case(&pr, sell, spmm, bounds, nblocks, threads);
+                    double err = spmm ? rel_error(pr.C, C_ref, (long long)rows * ncols)
+                                      : rel_error(pr.y, y_ref, rows);
+                    printf("%s, %s, %s, %d, %.2f, %.6f, %.2f, %.2e\n", spmm ? "SpMM" : "SpMV",
+                           sell ? "SELL" : "CSR", split_names[s], threads, imbal, elapsed,
+                           flop / elapsed * 1e-9, err);
+                }
+            }
+        }
+    }
+
+    free(bounds);
+    free(C_ref);
+    free(y_ref);
+    free(pr.C);
+    free(pr.B);
+    free(pr.y);
+    free(pr.x);
+    sell_free(&pr.S);
+    csr_free(&pr.A);
+    return 0;
+}
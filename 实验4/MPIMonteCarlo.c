@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <mpi.h>
+#include "../common/counter_rng.h"
+#include "mc_pi.h"
+
+/*
+ * 文件：MPIMonteCarlo.c
+ * 功能：MPI + pthread 混合并行的蒙特卡洛 pi 估计。
+ *       n 个点切成固定大小的任务块，每块的 xoshiro256+ 序列由 (种子, 块号) 经计数器随机数导出的种子初始化，
+ *       线程从自己的第一个块直接开始，不需要逐块跳转；
+ *       任务块先按块划分给各进程，进程内再按块划分给各线程，
+ *       各进程的整数计数用 MPI_Reduce 汇总到进程 0。
+ *       由于每块结果只取决于种子和块号，给定种子时估计值与进程数、线程数无关（逐位一致）。
+ */
+
+typedef struct {
+    _Alignas(64) long long b_begin;   // 本线程处理的任务块区间 [b_begin, b_end)
+    long long b_end;
+    long long n;
+    uint64_t seed;
+    long long in_circle;              // 本线程统计的落在圆内的点数
+} thread_arg_t;
+
+void* thread_func(void *arg) {
+    thread_arg_t *t = (thread_arg_t*)arg;
+    t->in_circle = mc_count_blocks(t->seed, t->n, t->b_begin, t->b_end);
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    int rank, size, provided;
+    long long n = 100000000LL;
+    int num_threads = 4;
+    unsigned long long seed = CRNG_DEFAULT_SEED;
+
+    // 只有主线程调用 MPI 函数
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    if (rank == 0) {
+        if (argc >= 2) n = atoll(argv[1]);
+        if (argc >= 3) num_threads = atoi(argv[2]);
+        if (argc >= 4) seed = strtoull(argv[3], NULL, 0);
+        if (n < 1 || num_threads < 1) {
+            fprintf(stderr, "Usage: %s [n] [threads_per_rank] [seed]\n", argv[0]);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+    }
+    MPI_Bcast(&n, 1, MPI_LONG_LONG, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&num_threads, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&seed, 1, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+
+    // 任务块按块划分给各进程
+    long long num_blocks = mc_pi_num_blocks(n);
+    long long my_begin = num_blocks * rank / size;
+    long long my_end = num_blocks * (rank + 1) / size;
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    double t_start = MPI_Wtime();
+
+    // 进程内再按块划分给各线程
+    pthread_t *threads = malloc(sizeof(pthread_t) * num_threads);
+    thread_arg_t *args = NULL;
+    if (!threads || posix_memalign((void**)&args, 64, sizeof(thread_arg_t) * num_threads) != 0) {
+        fprintf(stderr, "进程 %d 内存分配失败\n", rank);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    long long my_blocks = my_end - my_begin;
+    for (int i = 0; i < num_threads; ++i) {
+        args[i].b_begin = my_begin + my_blocks * i / num_threads;
+        args[i].b_end = my_begin + my_blocks * (i + 1) / num_threads;
+        args[i].n = n;
+        args[i].seed = seed;
+        args[i].in_circle = 0;
+        pthread_create(&threads[i], NULL, thread_func, &args[i]);
+    }
+    long long local_in = 0;
+    for (int i = 0; i < num_threads; ++i) {
+        pthread_join(threads[i], NULL);
+        local_in += args[i].in_circle;
+    }
+
+    // 汇总各进程的计数，整数求和与顺序无关
+    long long total_in = 0;
+    MPI_Reduce(&local_in, &total_in, 1, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    double local_time = MPI_Wtime() - t_start, max_time = 0.0;
+    MPI_Reduce(&local_time, &max_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        double pi_est = 4.0 * (double)total_in / (double)n;
+        printf("进程数: %d, 每进程线程数: %d, 任务块数: %lld, 种子: %llu\n",
+               size, num_threads, num_blocks, seed);
+        printf("n = %lld, m = %lld, pi_est = %.17g, 耗时: %.6f s, 吞吐: %.1f Mpts/s\n",
+               n, total_in, pi_est, max_time, n / max_time / 1e6);
+    }
+
+    free(threads);
+    free(args);
+    MPI_Finalize();
+    return 0;
+}
@@ -3,39 +3,40 @@
 #include <pthread.h>
 #include <sys/time.h>
 #include <time.h>
+#include "../common/counter_rng.h"
+#include "../common/xoshiro256.h"
+#include "../common/thread_affinity.h"
+#include "mc_pi.h"
 
 typedef struct {
     long long points;       // 本线程要生成的随机点数
-    unsigned int seed;      // rand_r 的种子
+    xs_state_t rng;         // 本线程的多路 xoshiro256+ 状态（互不重叠的子流）
     long long in_circle;    // 本线程统计的落在圆内的点数
+    int tid;                // 线程编号（用于绑核）
 } thread_arg_t;
 
 // 线程函数：生成随机点并统计落在单位圆内的个数
 void* thread_func(void *arg) {
     thread_arg_t *t = (thread_arg_t*)arg;
-    long long in_cnt = 0;
-    for (long long i = 0; i < t->points; ++i) {
-        double x = (double)rand_r(&t->seed) / RAND_MAX;
-        double y = (double)rand_r(&t->seed) / RAND_MAX;
-        if (x*x + y*y <= 1.0) {
-            ++in_cnt;
-        }
-    }
-    t->in_circle = in_cnt;
+    affinity_bind_self(t->tid);
+    t->in_circle = mc_count_in_circle(&t->rng, t->points);
     return NULL;
 }
 
 int main(void) {
     // 待测试的投点总数
-    long long n_values[]      = { 1000, 5000, 10000, 20000, 50000 };
+    long long n_values[]      = { 1000, 5000, 10000, 20000, 50000, 1000000, 100000000 };
     int       num_n           = sizeof(n_values) / sizeof(n_values[0]);
     // 待测试的线程数
     const int thread_options[] = { 1, 2, 4, 8, 16 };
     int       num_options     = sizeof(thread_options) / sizeof(thread_options[0]);
 
+    // 随机数种子（环境变量 RNG_SEED 覆盖）
+    uint64_t seed = crng_seed_from_env(CRNG_DEFAULT_SEED);
+
     // 打印表头
-    printf("     n\tThreads\t       m\t    pi_est\t time(s)\n");
-    printf("---------------------------------------------------------------\n");
+    printf("        n\tThreads\t        m\t    pi_est\t time(s)\t Mpts/s\n");
+    printf("-------------------------------------------------------------------------------\n");
 
     // 遍历所有 n 与线程数组合
     for (int ni = 0; ni < num_n; ++ni) {
@@ -47,13 +48,17 @@ int main(void) {
             pthread_t    *threads = malloc(sizeof(pthread_t) * num_threads);
             thread_arg_t *args    = calloc(num_threads, sizeof(thread_arg_t));
 
-            // 将 n 均分到各线程，最后一个线程分配余数
+            // 将 n 均分到各线程，最后一个线程分配余数；第 i 个线程使用第 i 个子流
             long long base = n / num_threads;
             long long rem  = n % num_threads;
+            xs_state_t rng;
+            xs_init(&rng, seed);
             for (int i = 0; i < num_threads; ++i) {
                 args[i].points    = base + (i == num_threads - 1 ? rem : 0);
-                args[i].seed      = (unsigned int)time(NULL) ^ (i * 0x9e3779b1);
+                args[i].rng       = rng;
                 args[i].in_circle = 0;
+                args[i].tid       = i;
+                xs_long_jump(&rng);
             }
 
             // 记录开始时间
@@ -80,8 +85,8 @@ int main(void) {
             double pi_est = 4.0 * (double)total_in / (double)n;
 
             // 输出一行结果
-            printf("%8lld\t%7d\t%7lld\t%10.8f\t%8.6f\n",
-                   n, num_threads, total_in, pi_est, elapsed);
+            printf("%9lld\t%7d\t%9lld\t%10.8f\t%8.6f\t%7.1f\n",
+                   n, num_threads, total_in, pi_est, elapsed, n / elapsed / 1e6);
 
             free(threads);
             free(args);
@@ -5,6 +5,11 @@
 #include <sys/time.h>
 #include <time.h>
 #include <stdbool.h>
+#include <string.h>
+#include "quadratic_batch.h"
+#include "task_graph.h"
+#include "ready_flag.h"
+#include "../common/counter_rng.h"
 
 // Coefficients and intermediates
 double a, b, c;
@@ -72,7 +77,286 @@ void *thread_compute_root2(void *arg) {
     return NULL;
 }
 
-int main() {
+/*
+ * 原始版本执行一次：重置就绪标志，每个计算步骤创建一个线程
+ */
+void solve_with_threads(void) {
+    ready_b2 = ready_4ac = ready_disc = ready_sqrt = false;
+    pthread_t t1, t2, t3, t4, t5, t6;
+    pthread_create(&t1, NULL, thread_compute_b2, NULL);
+    pthread_create(&t2, NULL, thread_compute_4ac, NULL);
+    pthread_create(&t3, NULL, thread_compute_disc, NULL);
+    pthread_create(&t4, NULL, thread_compute_sqrt, NULL);
+    pthread_create(&t5, NULL, thread_compute_root1, NULL);
+    pthread_create(&t6, NULL, thread_compute_root2, NULL);
+    pthread_join(t1, NULL);
+    pthread_join(t2, NULL);
+    pthread_join(t3, NULL);
+    pthread_join(t4, NULL);
+    pthread_join(t5, NULL);
+    pthread_join(t6, NULL);
+}
+
+// 任务图版本的各节点：依赖关系由任务图保证，节点内无需加锁或等待
+void node_b2(void *arg)    { (void)arg; b2 = b * b; }
+void node_4ac(void *arg)   { (void)arg; four_ac = 4.0 * a * c; }
+void node_disc(void *arg)  { (void)arg; discriminant = b2 - four_ac; }
+void node_sqrt(void *arg)  { (void)arg; if (discriminant >= 0) sqrt_disc = sqrt(discriminant); }
+void node_root1(void *arg) { (void)arg; if (discriminant >= 0) root1 = (-b + sqrt_disc) / (2.0 * a); }
+void node_root2(void *arg) { (void)arg; if (discriminant >= 0) root2 = (-b - sqrt_disc) / (2.0 * a); }
+
+/*
+ * 任务图模式：b^2、4ac -> 判别式 -> 开方 -> 两个根 的依赖链交给任务图执行器，
+ * 线程池常驻，对比每次求解的平均耗时与原始“每步一个线程”的版本。
+ */
+int run_dag(int reps, int num_workers) {
+    uint64_t key = crng_key(crng_seed_from_env(CRNG_DEFAULT_SEED), 3);
+    a = crng_uniform(key, 0) * 200.0 - 100.0;
+    b = crng_uniform(key, 1) * 200.0 - 100.0;
+    c = crng_uniform(key, 2) * 200.0 - 100.0;
+    printf("方程: %.3f x^2 + %.3f x + %.3f = 0, 重复 %d 次, 工作线程 %d 个\n", a, b, c, reps, num_workers);
+
+    struct timeval t0, t1;
+    gettimeofday(&t0, NULL);
+    for (int r = 0; r < reps; r++) solve_with_threads();
+    gettimeofday(&t1, NULL);
+    double us_threads = ((t1.tv_sec - t0.tv_sec) * 1e6 + (t1.tv_usec - t0.tv_usec)) / reps;
+    double th_root1 = root1, th_root2 = root2;
+
+    tg_graph_t *g = tg_create(num_workers);
+    int n_b2 = tg_add_node(g, node_b2, NULL);
+    int n_4ac = tg_add_node(g, node_4ac, NULL);
+    int n_disc = tg_add_node(g, node_disc, NULL);
+    int n_sqrt = tg_add_node(g, node_sqrt, NULL);
+    int n_r1 = tg_add_node(g, node_root1, NULL);
+    int n_r2 = tg_add_node(g, node_root2, NULL);
+    tg_add_dep(g, n_disc, n_b2);
+    tg_add_dep(g, n_disc, n_4ac);
+    tg_add_dep(g, n_sqrt, n_disc);
+    tg_add_dep(g, n_r1, n_sqrt);
+    tg_add_dep(g, n_r2, n_sqrt);
+
+    root1 = root2 = NAN;
+    gettimeofday(&t0, NULL);
+    for (int r = 0; r < reps; r++) tg_run(g);
+    gettimeofday(&t1, NULL);
+    double us_dag = ((t1.tv_sec - t0.tv_sec) * 1e6 + (t1.tv_usec - t0.tv_usec)) / reps;
+    tg_destroy(g);
+
+    if (discriminant < 0) {
+        printf("无实数根，判别式 = %.3f\n", discriminant);
+    } else {
+        printf("每步一个线程: 根1 = %.6f, 根2 = %.6f, 平均每次 %.3f us\n", th_root1, th_root2, us_threads);
+        printf("任务图执行器: 根1 = %.6f, 根2 = %.6f, 平均每次 %.3f us\n", root1, root2, us_dag);
+    }
+    return 0;
+}
+
+/*
+ * 原子标志模式：六个阶段线程常驻，阶段间通过 ready_flag 传递（acquire/release 发布，
+ * 自旋后 futex 休眠），不再共用一把互斥锁；b2 与 4ac 两个独立阶段可以真正并行。
+ * 每次求解使用一组新的标志，主线程等两个根都完成后才开始下一次，
+ * 因此测得的是各阶段之间单次传递的延迟。
+ */
+enum { F_START, F_B2, F_4AC, F_DISC, F_SQRT, F_ROOT1, F_ROOT2, NUM_FLAGS };
+enum { H_B2_DISC, H_4AC_DISC, H_DISC_SQRT, H_SQRT_ROOT1, H_SQRT_ROOT2, NUM_HANDOFFS };
+static const char *handoff_names[NUM_HANDOFFS] = {
+    "b2   -> disc", "4ac  -> disc", "disc -> sqrt", "sqrt -> root1", "sqrt -> root2"
+};
+
+typedef struct {
+    ready_flag_t *flags;       // reps × NUM_FLAGS
+    uint64_t *latency;         // NUM_HANDOFFS × reps，单位纳秒
+    int reps;
+} atomic_pipeline_t;
+
+static atomic_pipeline_t pipe_ctx;
+
+#define FLAG(r, f) (&pipe_ctx.flags[(size_t)(r) * NUM_FLAGS + (f)])
+#define LAT(h, r)  (pipe_ctx.latency[(size_t)(h) * pipe_ctx.reps + (r)])
+
+void *stage_b2(void *arg) {
+    (void)arg;
+    for (int r = 0; r < pipe_ctx.reps; r++) {
+        rf_wait(FLAG(r, F_START));
+        b2 = b * b;
+        rf_publish(FLAG(r, F_B2));
+    }
+    return NULL;
+}
+
+void *stage_4ac(void *arg) {
+    (void)arg;
+    for (int r = 0; r < pipe_ctx.reps; r++) {
+        rf_wait(FLAG(r, F_START));
+        four_ac = 4.0 * a * c;
+        rf_publish(FLAG(r, F_4AC));
+    }
+    return NULL;
+}
+
+void *stage_disc(void *arg) {
+    (void)arg;
+    for (int r = 0; r < pipe_ctx.reps; r++) {
+        // 两个输入同时等待，各自的延迟在首次观察到就绪时记录，不含等待另一个输入的时间
+        rf_wait2(FLAG(r, F_B2), FLAG(r, F_4AC), &LAT(H_B2_DISC, r), &LAT(H_4AC_DISC, r));
+        discriminant = b2 - four_ac;
+        rf_publish(FLAG(r, F_DISC));
+    }
+    return NULL;
+}
+
+void *stage_sqrt(void *arg) {
+    (void)arg;
+    for (int r = 0; r < pipe_ctx.reps; r++) {
+        LAT(H_DISC_SQRT, r) = rf_wait(FLAG(r, F_DISC));
+        if (discriminant >= 0) sqrt_disc = sqrt(discriminant);
+        rf_publish(FLAG(r, F_SQRT));
+    }
+    return NULL;
+}
+
+void *stage_root1(void *arg) {
+    (void)arg;
+    for (int r = 0; r < pipe_ctx.reps; r++) {
+        LAT(H_SQRT_ROOT1, r) = rf_wait(FLAG(r, F_SQRT));
+        if (discriminant >= 0) root1 = (-b + sqrt_disc) / (2.0 * a);
+        rf_publish(FLAG(r, F_ROOT1));
+    }
+    return NULL;
+}
+
+void *stage_root2(void *arg) {
+    (void)arg;
+    for (int r = 0; r < pipe_ctx.reps; r++) {
+        LAT(H_SQRT_ROOT2, r) = rf_wait(FLAG(r, F_SQRT));
+        if (discriminant >= 0) root2 = (-b - sqrt_disc) / (2.0 * a);
+        rf_publish(FLAG(r, F_ROOT2));
+    }
+    return NULL;
+}
+
+static int cmp_u64(const void *x, const void *y) {
+    uint64_t u = *(const uint64_t *)x, v = *(const uint64_t *)y;
+    return (u > v) - (u < v);
+}
+
+int run_atomic(int reps) {
+    uint64_t key = crng_key(crng_seed_from_env(CRNG_DEFAULT_SEED), 3);
+    a = crng_uniform(key, 0) * 200.0 - 100.0;
+    b = crng_uniform(key, 1) * 200.0 - 100.0;
+    c = crng_uniform(key, 2) * 200.0 - 100.0;
+    printf("方程: %.3f x^2 + %.3f x + %.3f = 0, 重复 %d 次\n", a, b, c, reps);
+
+    pipe_ctx.reps = reps;
+    pipe_ctx.latency = malloc(sizeof(uint64_t) * NUM_HANDOFFS * reps);
+    if (posix_memalign((void **)&pipe_ctx.flags, 64, sizeof(ready_flag_t) * NUM_FLAGS * (size_t)reps) != 0 ||
+        !pipe_ctx.latency) {
+        fprintf(stderr, "内存分配失败\n");
+        return 1;
+    }
+    for (size_t i = 0; i < (size_t)NUM_FLAGS * reps; i++) rf_init(&pipe_ctx.flags[i]);
+
+    void *(*stages[6])(void *) = { stage_b2, stage_4ac, stage_disc, stage_sqrt, stage_root1, stage_root2 };
+    pthread_t threads[6];
+    for (int i = 0; i < 6; i++) pthread_create(&threads[i], NULL, stages[i], NULL);
+
+    uint64_t total_ns = 0;
+    for (int r = 0; r < reps; r++) {
+        uint64_t t0 = rf_now_ns();
+        rf_publish(FLAG(r, F_START));
+        rf_wait(FLAG(r, F_ROOT1));
+        rf_wait(FLAG(r, F_ROOT2));
+        total_ns += rf_now_ns() - t0;
+    }
+    for (int i = 0; i < 6; i++) pthread_join(threads[i], NULL);
+
+    if (discriminant < 0) printf("无实数根，判别式 = %.3f\n", discriminant);
+    else printf("根1 = %.6f, 根2 = %.6f\n", root1, root2);
+    printf("平均每次求解（发布起始标志到两个根完成）: %.3f us\n", total_ns / 1e3 / reps);
+    printf("%-14s %12s %12s %12s %12s\n", "传递", "mean(ns)", "p50(ns)", "p99(ns)", "max(ns)");
+    for (int h = 0; h < NUM_HANDOFFS; h++) {
+        uint64_t *lat = &LAT(h, 0);
+        double sum = 0.0;
+        for (int r = 0; r < reps; r++) sum += (double)lat[r];
+        qsort(lat, reps, sizeof(uint64_t), cmp_u64);
+        printf("%-14s %12.0f %12llu %12llu %12llu\n", handoff_names[h], sum / reps,
+               (unsigned long long)lat[reps / 2], (unsigned long long)lat[(long long)reps * 99 / 100],
+               (unsigned long long)lat[reps - 1]);
+    }
+
+    free(pipe_ctx.flags);
+    free(pipe_ctx.latency);
+    return 0;
+}
+
+/*
+ * 批量模式：随机生成 n 个方程（SoA 布局），用 qe_solve_batch 在不同线程数下求解，
+ * 以每秒求解的方程数衡量吞吐。
+ */
+int run_batch(long long n) {
+    const int thread_options[] = {1, 2, 4, 8, 16};
+    const int num_options = sizeof(thread_options) / sizeof(thread_options[0]);
+    double *ca = malloc(sizeof(double) * n);
+    double *cb = malloc(sizeof(double) * n);
+    double *cc = malloc(sizeof(double) * n);
+    double *r1 = malloc(sizeof(double) * n);
+    double *r2 = malloc(sizeof(double) * n);
+    if (!ca || !cb || !cc || !r1 || !r2) {
+        fprintf(stderr, "内存分配失败\n");
+        return 1;
+    }
+    uint64_t seed = crng_seed_from_env(CRNG_DEFAULT_SEED);
+    crng_fill_uniform(ca, 0, n, crng_key(seed, 0), -100.0, 100.0);
+    crng_fill_uniform(cb, 0, n, crng_key(seed, 1), -100.0, 100.0);
+    crng_fill_uniform(cc, 0, n, crng_key(seed, 2), -100.0, 100.0);
+
+    printf("批量求解 %lld 个方程\n", n);
+    printf("Threads\t   实根方程数\t   time(ms)\t  Meq/s\n");
+    long long real_count = 0;
+    for (int t = 0; t < num_options; t++) {
+        double best = 1e30;
+        for (int rep = 0; rep < 3; rep++) {
+            struct timeval t0, t1;
+            gettimeofday(&t0, NULL);
+            real_count = qe_solve_batch(ca, cb, cc, r1, r2, n, thread_options[t]);
+            gettimeofday(&t1, NULL);
+            double ms = (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_usec - t0.tv_usec) * 1e-3;
+            if (ms < best) best = ms;
+        }
+        printf("%7d\t%12lld\t%11.3f\t%7.1f\n", thread_options[t], real_count, best, n / (best * 1e-3) / 1e6);
+    }
+
+    // 用相对残差 |a x^2 + b x + c| / (|a x^2| + |b x| + |c|) 检验精度
+    double max_res = 0.0;
+    for (long long i = 0; i < n; i++) {
+        if (isnan(r1[i])) continue;
+        double xs[2] = {r1[i], r2[i]};
+        for (int k = 0; k < 2; k++) {
+            double x = xs[k];
+            double scale = fabs(ca[i] * x * x) + fabs(cb[i] * x) + fabs(cc[i]);
+            double res = scale > 0 ? fabs((ca[i] * x + cb[i]) * x + cc[i]) / scale : 0.0;
+            if (res > max_res) max_res = res;
+        }
+    }
+    printf("最大相对残差: %.3e\n", max_res);
+
+    free(ca); free(cb); free(cc); free(r1); free(r2);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc >= 2 && strcmp(argv[1], "batch") == 0) {
+        return run_batch((argc >= 3) ? atoll(argv[2]) : 10000000LL);
+    }
+    if (argc >= 2 && strcmp(argv[1], "atomic") == 0) {
+        int reps = (argc >= 3) ? atoi(argv[2]) : 10000;
+        return run_atomic(reps > 0 ? reps : 1);
+    }
+    if (argc >= 2 && strcmp(argv[1], "dag") == 0) {
+        return run_dag((argc >= 3) ? atoi(argv[2]) : 10000, (argc >= 4) ? atoi(argv[3]) : 2);
+    }
+
     srand((unsigned)time(NULL));
     // Generate random coefficients
     a = (rand() / (double)RAND_MAX) * 200.0 - 100.0;
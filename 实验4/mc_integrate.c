@@ -0,0 +1,307 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "mc_integrate.h"
+#include "../common/xoshiro256.h"
+
+#define MC_MAX_DIM        64
+#define MC_MAX_THREADS    256
+#define MC_SOBOL_MAX_DIM  16
+#define MC_SOBOL_BITS     32
+#define MC_MIN_REPLICATES 8     // 至少这么多重复样本后才用误差判断是否停止
+#define MC_CHUNK          64    // 普通/对偶采样时一次生成的点数
+
+/* Sobol 方向数（Joe & Kuo, new-joe-kuo-6.21201），第 0 维为 van der Corput 序列 */
+static const struct { int s, a; int m[6]; } sobol_table[MC_SOBOL_MAX_DIM - 1] = {
+    {1, 0,  {1}},
+    {2, 1,  {1, 3}},
+    {3, 1,  {1, 3, 1}},
+    {3, 2,  {1, 1, 1}},
+    {4, 1,  {1, 1, 3, 3}},
+    {4, 4,  {1, 3, 5, 13}},
+    {5, 2,  {1, 1, 5, 5, 17}},
+    {5, 4,  {1, 1, 5, 5, 5}},
+    {5, 7,  {1, 1, 7, 11, 19}},
+    {5, 11, {1, 1, 5, 1, 1}},
+    {5, 13, {1, 1, 1, 3, 11}},
+    {5, 14, {1, 3, 5, 5, 31}},
+    {6, 1,  {1, 3, 3, 9, 7, 49}},
+    {6, 13, {1, 1, 1, 15, 21, 21}},
+    {6, 16, {1, 3, 1, 13, 27, 49}},
+};
+
+struct mc_engine;
+
+/* 每个工作线程的数据，按缓存行对齐避免伪共享 */
+typedef struct {
+    _Alignas(64) int tid;
+    struct mc_engine *eng;
+    xs_state_t rng;
+    double mean;             // 本轮重复样本的均值
+    long long evals;         // 本轮被积函数调用次数
+} mc_worker_t;
+
+typedef struct mc_engine {
+    mc_integrand f;
+    void *arg;
+    const mc_options_t *opt;
+    mc_method_t method;      // 实际使用的采样方式（维数过高时分层退化为普通采样）
+    double width[MC_MAX_DIM];
+    long long points;        // 每个重复样本的点数（对偶采样为点对数）
+    int strata;              // 分层采样每维层数
+    uint32_t sobol_v[MC_SOBOL_MAX_DIM][MC_SOBOL_BITS];
+
+    pthread_mutex_t mtx;
+    pthread_cond_t cv_start;
+    pthread_cond_t cv_done;
+    int round;               // 当前轮编号，工作线程看到它变化即开始新一轮
+    int done;                // 本轮已完成的线程数
+    int stop;
+} mc_engine_t;
+
+const char *mc_method_name(mc_method_t method) {
+    switch (method) {
+    case MC_PLAIN:      return "plain";
+    case MC_ANTITHETIC: return "antithetic";
+    case MC_STRATIFIED: return "stratified";
+    case MC_SOBOL:      return "sobol";
+    }
+    return "unknown";
+}
+
+void mc_default_options(mc_options_t *opt, int dim, const double *lo, const double *hi) {
+    opt->dim = dim;
+    opt->lo = lo;
+    opt->hi = hi;
+    opt->method = MC_PLAIN;
+    opt->num_threads = 4;
+    opt->batch = 4096;
+    opt->max_samples = 100000000LL;
+    opt->tol = 0.0;
+    opt->seed = 20240901ULL;
+}
+
+static void sobol_init(mc_engine_t *eng, int dim) {
+    for (int k = 0; k < MC_SOBOL_BITS; ++k)
+        eng->sobol_v[0][k] = 1u << (MC_SOBOL_BITS - 1 - k);
+    for (int d = 1; d < dim; ++d) {
+        int s = sobol_table[d - 1].s, a = sobol_table[d - 1].a;
+        uint32_t *v = eng->sobol_v[d];
+        for (int k = 0; k < s; ++k)
+            v[k] = (uint32_t)sobol_table[d - 1].m[k] << (MC_SOBOL_BITS - 1 - k);
+        for (int k = s; k < MC_SOBOL_BITS; ++k) {
+            v[k] = v[k - s] ^ (v[k - s] >> s);
+            for (int l = 1; l < s; ++l)
+                if ((a >> (s - 1 - l)) & 1) v[k] ^= v[k - l];
+        }
+    }
+}
+
+// 把单位超立方体中的点映射到积分区域并求值
+static inline double eval_at(const mc_engine_t *eng, const double *u, double *x) {
+    const int dim = eng->opt->dim;
+    for (int j = 0; j < dim; ++j) x[j] = eng->opt->lo[j] + eng->width[j] * u[j];
+    return eng->f(x, dim, eng->arg);
+}
+
+// 计算一个重复样本：结果写入 w->mean 与 w->evals
+static void run_replicate(mc_worker_t *w) {
+    const mc_engine_t *eng = w->eng;
+    const int dim = eng->opt->dim;
+    double u[MC_MAX_DIM], x[MC_MAX_DIM];
+    double sum = 0.0;
+    long long evals = 0;
+
+    switch (eng->method) {
+    case MC_PLAIN:
+    case MC_ANTITHETIC: {
+        const int anti = (eng->method == MC_ANTITHETIC);
+        double ubuf[MC_CHUNK * MC_MAX_DIM];
+        for (long long i = 0; i < eng->points; i += MC_CHUNK) {
+            long long n = (eng->points - i < MC_CHUNK) ? eng->points - i : MC_CHUNK;
+            xs_uniform_batch(&w->rng, ubuf, n * dim);
+            for (long long p = 0; p < n; ++p) {
+                const double *up = ubuf + p * dim;
+                double v = eval_at(eng, up, x);
+                if (anti) {
+                    for (int j = 0; j < dim; ++j) u[j] = 1.0 - up[j];
+                    v = 0.5 * (v + eval_at(eng, u, x));
+                }
+                sum += v;
+            }
+        }
+        evals = eng->points * (anti ? 2 : 1);
+        break;
+    }
+    case MC_STRATIFIED: {
+        const int s = eng->strata;
+        int idx[MC_MAX_DIM] = {0};
+        double r[MC_MAX_DIM];
+        for (long long c = 0; c < eng->points; ++c) {
+            xs_uniform_batch(&w->rng, r, dim);
+            for (int j = 0; j < dim; ++j) u[j] = (idx[j] + r[j]) / s;
+            sum += eval_at(eng, u, x);
+            // 按 s 进制递增小格下标
+            for (int j = 0; j < dim && ++idx[j] == s; ++j) idx[j] = 0;
+        }
+        evals = eng->points;
+        break;
+    }
+    case MC_SOBOL: {
+        uint32_t shift[MC_MAX_DIM], q[MC_MAX_DIM] = {0};
+        uint64_t raw[XS_LANES];
+        for (int j = 0; j < dim; j += XS_LANES) {
+            xs_next_lanes(&w->rng, raw);
+            for (int l = 0; l < XS_LANES && j + l < dim; ++l) shift[j + l] = (uint32_t)(raw[l] >> 32);
+        }
+        for (long long n = 0; n < eng->points; ++n) {
+            if (n > 0) {
+                int c = __builtin_ctzll(~(unsigned long long)(n - 1));   // Gray 码更新
+                for (int j = 0; j < dim; ++j) q[j] ^= eng->sobol_v[j][c];
+            }
+            for (int j = 0; j < dim; ++j) u[j] = (double)(q[j] ^ shift[j]) * 0x1.0p-32;
+            sum += eval_at(eng, u, x);
+        }
+        evals = eng->points;
+        break;
+    }
+    }
+    w->mean = sum / (double)eng->points;
+    w->evals = evals;
+}
+
+// 常驻工作线程：等待新一轮开始，完成后通知主线程
+static void *mc_worker(void *p) {
+    mc_worker_t *w = (mc_worker_t *)p;
+    mc_engine_t *eng = w->eng;
+    int seen = 0;
+    for (;;) {
+        pthread_mutex_lock(&eng->mtx);
+        while (eng->round == seen && !eng->stop)
+            pthread_cond_wait(&eng->cv_start, &eng->mtx);
+        if (eng->stop) {
+            pthread_mutex_unlock(&eng->mtx);
+            break;
+        }
+        seen = eng->round;
+        pthread_mutex_unlock(&eng->mtx);
+
+        run_replicate(w);
+
+        pthread_mutex_lock(&eng->mtx);
+        if (++eng->done == eng->opt->num_threads) pthread_cond_signal(&eng->cv_done);
+        pthread_mutex_unlock(&eng->mtx);
+    }
+    return NULL;
+}
+
+int mc_integrate(mc_integrand f, void *arg, const mc_options_t *opt, mc_result_t *res) {
+    const int dim = opt->dim, nt = opt->num_threads;
+    if (dim < 1 || dim > MC_MAX_DIM || nt < 1 || nt > MC_MAX_THREADS || opt->batch < 1)
+        return -1;
+    if (opt->method == MC_SOBOL && dim > MC_SOBOL_MAX_DIM)
+        return -1;
+
+    mc_engine_t *eng = calloc(1, sizeof(mc_engine_t));
+    mc_worker_t *workers = NULL;
+    if (!eng || posix_memalign((void **)&workers, 64, sizeof(mc_worker_t) * nt) != 0) {
+        free(eng);
+        return -1;
+    }
+    eng->f = f;
+    eng->arg = arg;
+    eng->opt = opt;
+    eng->method = opt->method;
+    double volume = 1.0;
+    for (int j = 0; j < dim; ++j) {
+        eng->width[j] = opt->hi[j] - opt->lo[j];
+        volume *= eng->width[j];
+    }
+
+    // 每个重复样本的点数：对偶采样为点对数；分层取 s^dim；Sobol 取 2 的幂
+    eng->points = opt->batch;
+    if (opt->method == MC_ANTITHETIC) {
+        eng->points = (opt->batch + 1) / 2;
+    } else if (opt->method == MC_STRATIFIED) {
+        int s = (int)floor(pow((double)opt->batch, 1.0 / dim) + 1e-9);
+        if (s < 2) {
+            eng->method = MC_PLAIN;    // 每维不足 2 层，分层没有意义
+        } else {
+            eng->strata = s;
+            eng->points = 1;
+            for (int j = 0; j < dim; ++j) eng->points *= s;
+        }
+    } else if (opt->method == MC_SOBOL) {
+        long long p = 1;
+        while (p < opt->batch && p < (1LL << MC_SOBOL_BITS)) p <<= 1;
+        eng->points = p;
+        sobol_init(eng, dim);
+    }
+
+    pthread_mutex_init(&eng->mtx, NULL);
+    pthread_cond_init(&eng->cv_start, NULL);
+    pthread_cond_init(&eng->cv_done, NULL);
+
+    // 第 t 个线程使用第 t 个 long-jump 子流
+    xs_state_t rng;
+    xs_init(&rng, opt->seed);
+    pthread_t threads[MC_MAX_THREADS];
+    for (int t = 0; t < nt; ++t) {
+        workers[t].tid = t;
+        workers[t].eng = eng;
+        workers[t].rng = rng;
+        xs_long_jump(&rng);
+        pthread_create(&threads[t], NULL, mc_worker, &workers[t]);
+    }
+
+    // 按重复样本均值做 Welford 在线统计
+    long long reps = 0, samples = 0;
+    double mean = 0.0, m2 = 0.0, se = INFINITY;
+    int converged = 0;
+    long long per_round = (long long)nt * eng->points * (eng->method == MC_ANTITHETIC ? 2 : 1);
+    for (;;) {
+        pthread_mutex_lock(&eng->mtx);
+        eng->done = 0;
+        eng->round++;
+        pthread_cond_broadcast(&eng->cv_start);
+        while (eng->done < nt)
+            pthread_cond_wait(&eng->cv_done, &eng->mtx);
+        pthread_mutex_unlock(&eng->mtx);
+
+        for (int t = 0; t < nt; ++t) {
+            double delta = workers[t].mean - mean;
+            ++reps;
+            mean += delta / reps;
+            m2 += delta * (workers[t].mean - mean);
+            samples += workers[t].evals;
+        }
+        if (reps > 1) se = sqrt(m2 / (reps - 1) / reps) * fabs(volume);
+
+        if (opt->tol > 0.0 && reps >= MC_MIN_REPLICATES && se <= opt->tol) {
+            converged = 1;
+            break;
+        }
+        if (samples + per_round > opt->max_samples) break;
+    }
+
+    pthread_mutex_lock(&eng->mtx);
+    eng->stop = 1;
+    pthread_cond_broadcast(&eng->cv_start);
+    pthread_mutex_unlock(&eng->mtx);
+    for (int t = 0; t < nt; ++t) pthread_join(threads[t], NULL);
+
+    res->estimate = mean * volume;
+    res->std_error = se;
+    res->samples = samples;
+    res->replicates = reps;
+    res->converged = converged;
+
+    pthread_mutex_destroy(&eng->mtx);
+    pthread_cond_destroy(&eng->cv_start);
+    pthread_cond_destroy(&eng->cv_done);
+    free(workers);
+    free(eng);
+    return 0;
+}
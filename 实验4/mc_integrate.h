@@ -0,0 +1,57 @@
+#ifndef MC_INTEGRATE_H
+#define MC_INTEGRATE_H
+
+#include <stdint.h>
+
+/*
+ * 并行蒙特卡洛积分引擎：在超矩形 [lo, hi] 上积分用户给出的被积函数。
+ *
+ * 计算按轮进行：每一轮中每个工作线程生成一个“重复样本”——batch 个点的
+ * 均值估计。误差由所有重复样本均值的标准差估计，每轮结束后若标准误差
+ * 不超过 tol 则提前停止。工作线程在整个积分过程中常驻，只在轮与轮之间同步。
+ *
+ * 采样方式：
+ *   MC_PLAIN       普通独立均匀采样
+ *   MC_ANTITHETIC  对偶变量：每个 u 同时计算 u 与 1-u，取平均
+ *   MC_STRATIFIED  分层采样：每维分 s 层（s^dim <= batch），每个小格内随机取一点
+ *   MC_SOBOL       随机化 Sobol 序列（每个重复样本使用不同的随机数字移位），dim <= 16
+ */
+
+typedef double (*mc_integrand)(const double *x, int dim, void *arg);
+
+typedef enum {
+    MC_PLAIN = 0,
+    MC_ANTITHETIC,
+    MC_STRATIFIED,
+    MC_SOBOL
+} mc_method_t;
+
+typedef struct {
+    int dim;                 // 维数
+    const double *lo;        // 各维下界
+    const double *hi;        // 各维上界
+    mc_method_t method;      // 采样方式
+    int num_threads;         // 工作线程数
+    long long batch;         // 每个重复样本的点数（分层/Sobol 会相应取整）
+    long long max_samples;   // 最多使用的被积函数调用次数
+    double tol;              // 目标标准误差（绝对值），<= 0 表示一直算到 max_samples
+    uint64_t seed;           // 随机数种子
+} mc_options_t;
+
+typedef struct {
+    double estimate;         // 积分估计值
+    double std_error;        // 标准误差估计
+    long long samples;       // 实际被积函数调用次数
+    long long replicates;    // 重复样本个数
+    int converged;           // 是否在达到 max_samples 前满足 tol
+} mc_result_t;
+
+// 填入默认参数：单位超立方体需由调用者给出 lo/hi
+void mc_default_options(mc_options_t *opt, int dim, const double *lo, const double *hi);
+
+// 成功返回 0；参数非法（如 Sobol 维数超过 16）返回 -1
+int mc_integrate(mc_integrand f, void *arg, const mc_options_t *opt, mc_result_t *res);
+
+const char *mc_method_name(mc_method_t method);
+
+#endif
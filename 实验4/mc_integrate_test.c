@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <sys/time.h>
+#include "mc_integrate.h"
+#include "../common/counter_rng.h"
+
+// 单位正方形中四分之一圆的指示函数，积分值为 pi/4
+double quarter_circle(const double *x, int dim, void *arg) {
+    (void)dim; (void)arg;
+    return (x[0] * x[0] + x[1] * x[1] <= 1.0) ? 1.0 : 0.0;
+}
+
+// exp(-|x|^2)，在 [0,1]^dim 上的积分为 (sqrt(pi)/2 * erf(1))^dim
+double gaussian(const double *x, int dim, void *arg) {
+    (void)arg;
+    double r2 = 0.0;
+    for (int j = 0; j < dim; ++j) r2 += x[j] * x[j];
+    return exp(-r2);
+}
+
+typedef struct {
+    const char *name;
+    mc_integrand f;
+    int dim;
+    double scale;     // 估计值乘以 scale 后与 exact 比较
+    double exact;
+} problem_t;
+
+int main(int argc, char *argv[]) {
+    int num_threads = (argc >= 2) ? atoi(argv[1]) : 4;
+    double tol = (argc >= 3) ? atof(argv[2]) : 1e-4;
+
+    double lo[8], hi[8];
+    for (int j = 0; j < 8; ++j) { lo[j] = 0.0; hi[j] = 1.0; }
+    problem_t problems[] = {
+        { "pi (2D indicator)", quarter_circle, 2, 4.0, M_PI },
+        { "gaussian 5D",       gaussian,       5, 1.0, pow(sqrt(M_PI) / 2.0 * erf(1.0), 5) },
+    };
+    int num_problems = sizeof(problems) / sizeof(problems[0]);
+    mc_method_t methods[] = { MC_PLAIN, MC_ANTITHETIC, MC_STRATIFIED, MC_SOBOL };
+    int num_methods = sizeof(methods) / sizeof(methods[0]);
+
+    printf("线程数: %d, 目标标准误差: %g\n", num_threads, tol);
+    printf("%-18s %-11s %12s %12s %12s %12s %10s\n",
+           "problem", "method", "estimate", "abs_err", "std_err", "samples", "time(s)");
+    printf("------------------------------------------------------------------------------------------------\n");
+    for (int p = 0; p < num_problems; ++p) {
+        for (int m = 0; m < num_methods; ++m) {
+            mc_options_t opt;
+            mc_result_t res;
+            mc_default_options(&opt, problems[p].dim, lo, hi);
+            opt.method = methods[m];
+            opt.num_threads = num_threads;
+            opt.tol = tol / problems[p].scale;
+            opt.seed = crng_seed_from_env(CRNG_DEFAULT_SEED);
+
+            struct timeval t0, t1;
+            gettimeofday(&t0, NULL);
+            if (mc_integrate(problems[p].f, NULL, &opt, &res) != 0) {
+                fprintf(stderr, "参数错误\n");
+                return 1;
+            }
+            gettimeofday(&t1, NULL);
+            double elapsed = (t1.tv_sec - t0.tv_sec) + (t1.tv_usec - t0.tv_usec) / 1e6;
+
+            double est = res.estimate * problems[p].scale;
+            printf("%-18s %-11s %12.8f %12.3e %12.3e %12lld %10.4f%s\n",
+                   problems[p].name, mc_method_name(methods[m]), est,
+                   fabs(est - problems[p].exact), res.std_error * problems[p].scale,
+                   res.samples, elapsed, res.converged ? "" : "  (未收敛)");
+        }
+    }
+    return 0;
+}
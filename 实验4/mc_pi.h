@@ -0,0 +1,63 @@
+#ifndef MC_PI_H
+#define MC_PI_H
+
+#include "../common/xoshiro256.h"
+#include "../common/counter_rng.h"
+
+/*
+ * 统计 points 个随机点中落在单位圆内的个数。
+ * 每步同时生成 XS_LANES 个 x 和 XS_LANES 个 y，圆内判断写成无分支的比较累加，
+ * 整个循环体可以被编译器向量化，随机数不经过内存。
+ */
+static inline long long mc_count_in_circle(xs_state_t *state, long long points) {
+    xs_state_t local = *state;   // 拷贝到局部变量，便于编译器把状态保存在寄存器中
+    xs_state_t *rng = &local;
+    long long in_cnt = 0;
+    long long i = 0;
+    double x[XS_LANES], y[XS_LANES];
+    for (; i + XS_LANES <= points; i += XS_LANES) {
+        xs_uniform_lanes(rng, x);
+        xs_uniform_lanes(rng, y);
+        int batch = 0;
+        for (int j = 0; j < XS_LANES; ++j)
+            batch += (x[j] * x[j] + y[j] * y[j] <= 1.0);
+        in_cnt += batch;
+    }
+    if (i < points) {
+        xs_uniform_lanes(rng, x);
+        xs_uniform_lanes(rng, y);
+        for (int j = 0; i < points; ++i, ++j)
+            in_cnt += (x[j] * x[j] + y[j] * y[j] <= 1.0);
+    }
+    *state = local;
+    return in_cnt;
+}
+
+/*
+ * 按固定大小的任务块统计：总共 n 个点切成 MC_PI_BLOCK 个点一块，统计 [b_begin, b_end) 各块的结果之和。
+ * 第 b 块的随机序列由计数器随机数导出的种子 crng_key(seed, b) 初始化（common/counter_rng.h），
+ * 任何线程可以直接从任意块开始，开销与块号无关；不同种子的 xoshiro256+ 序列在 2^256 的周期上
+ * 随机分布，2^20 个点的块之间发生重叠的概率可以忽略。
+ * 每块的结果只由 (seed, b) 决定，与块被分给哪个进程、哪个线程无关，
+ * 计数是整数求和，因此最终结果与进程数、线程数无关（逐位一致）。
+ */
+#define MC_PI_BLOCK (1LL << 20)
+
+static inline long long mc_pi_num_blocks(long long n) {
+    return (n + MC_PI_BLOCK - 1) / MC_PI_BLOCK;
+}
+
+static inline long long mc_count_blocks(uint64_t seed, long long n,
+                                        long long b_begin, long long b_end) {
+    long long in_cnt = 0;
+    for (long long b = b_begin; b < b_end; ++b) {
+        long long first = b * MC_PI_BLOCK;
+        long long points = (n - first < MC_PI_BLOCK) ? n - first : MC_PI_BLOCK;
+        xs_state_t block_rng;
+        xs_init(&block_rng, crng_key(seed, (uint64_t)b));
+        in_cnt += mc_count_in_circle(&block_rng, points);
+    }
+    return in_cnt;
+}
+
+#endif
@@ -0,0 +1,75 @@
+#include <stdlib.h>
+#include <math.h>
+#include <pthread.h>
+#include "quadratic_batch.h"
+
+#define QE_MAX_THREADS 256
+#define QE_MIN_PER_THREAD 65536   // 每个线程至少处理的方程数，小批量直接串行
+
+typedef struct {
+    _Alignas(64) const double *a;
+    const double *b, *c;
+    double *root1, *root2;
+    long long begin, end;
+    long long real_count;          // 本线程中有实数根的方程个数
+} qe_task_t;
+
+// 求解 [begin, end) 区间。只用比较-选择而不用 fmax/copysign，循环体无分支，便于向量化
+static long long qe_solve_range(const double *restrict a, const double *restrict b,
+                                const double *restrict c, double *restrict root1,
+                                double *restrict root2, long long begin, long long end) {
+    long long real_count = 0;
+    for (long long i = begin; i < end; ++i) {
+        double ai = a[i], bi = b[i], ci = c[i];
+        double disc = bi * bi - 4.0 * ai * ci;
+        double sd = sqrt(disc > 0.0 ? disc : 0.0);
+        sd = (bi < 0.0) ? -sd : sd;
+        double q = -0.5 * (bi + sd);
+        double x1 = q / ai;
+        double x2 = ci / q;
+        x2 = (q != 0.0) ? x2 : x1;                 // b == 0 且 Δ == 0
+        double lin = -ci / bi;                     // a == 0：退化为一次方程
+        x1 = (ai != 0.0) ? x1 : lin;
+        x2 = (ai != 0.0) ? x2 : lin;
+        double hi = (x1 > x2) ? x1 : x2;
+        double lo = (x1 > x2) ? x2 : x1;
+        int ok = ((ai != 0.0) & (disc >= 0.0)) | ((ai == 0.0) & (bi != 0.0));   // a == b == 0：无解或任意解，不计入
+        root1[i] = ok ? hi : NAN;
+        root2[i] = ok ? lo : NAN;
+        real_count += ok;
+    }
+    return real_count;
+}
+
+static void *qe_worker(void *p) {
+    qe_task_t *t = (qe_task_t *)p;
+    t->real_count = qe_solve_range(t->a, t->b, t->c, t->root1, t->root2, t->begin, t->end);
+    return NULL;
+}
+
+long long qe_solve_batch(const double *a, const double *b, const double *c,
+                         double *root1, double *root2, long long n, int num_threads) {
+    if (num_threads > QE_MAX_THREADS) num_threads = QE_MAX_THREADS;
+    if (num_threads > n / QE_MIN_PER_THREAD) num_threads = (int)(n / QE_MIN_PER_THREAD);
+    if (num_threads <= 1)
+        return qe_solve_range(a, b, c, root1, root2, 0, n);
+
+    pthread_t threads[QE_MAX_THREADS];
+    qe_task_t *tasks = NULL;
+    if (posix_memalign((void **)&tasks, 64, sizeof(qe_task_t) * num_threads) != 0)
+        return qe_solve_range(a, b, c, root1, root2, 0, n);
+
+    for (int t = 0; t < num_threads; ++t) {
+        tasks[t] = (qe_task_t){ a, b, c, root1, root2,
+                                n * t / num_threads, n * (t + 1) / num_threads, 0 };
+        if (t > 0) pthread_create(&threads[t], NULL, qe_worker, &tasks[t]);
+    }
+    qe_worker(&tasks[0]);   // 主线程处理第 0 块
+    long long real_count = tasks[0].real_count;
+    for (int t = 1; t < num_threads; ++t) {
+        pthread_join(threads[t], NULL);
+        real_count += tasks[t].real_count;
+    }
+    free(tasks);
+    return real_count;
+}
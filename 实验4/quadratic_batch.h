@@ -0,0 +1,19 @@
+#ifndef QUADRATIC_BATCH_H
+#define QUADRATIC_BATCH_H
+
+/*
+ * 批量求解一元二次方程 a[i] x^2 + b[i] x + c[i] = 0（SoA 布局：系数与结果各自为连续数组）。
+ *
+ * 采用数值稳定的求根公式，避免 -b 与 sqrt(Δ) 相近时的相消误差：
+ *     q  = -(b + sign(b) * sqrt(Δ)) / 2
+ *     x1 = q / a,  x2 = c / q
+ * 结果中 root1 >= root2；Δ < 0 时两根均为 NAN；a == 0 时按一次方程处理（两根均为 -c/b），
+ * a == 0 且 b == 0 时两根均为 NAN，不计入返回值。
+ * 内层循环不含分支，用 -O3 -fno-math-errno 编译时 sqrt 与除法可以被向量化。
+ *
+ * 返回有实数根的方程个数。
+ */
+long long qe_solve_batch(const double *a, const double *b, const double *c,
+                         double *root1, double *root2, long long n, int num_threads);
+
+#endif
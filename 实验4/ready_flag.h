@@ -0,0 +1,124 @@
+#ifndef READY_FLAG_H
+#define READY_FLAG_H
+
+/*
+ * 一次性就绪标志：生产者写完数据后发布，消费者等待发布后读取数据。
+ *
+ * 发布使用 release 写、等待使用 acquire 读，生产者在发布前写入的数据对消费者可见，
+ * 不需要互斥锁。等待方先自旋一段时间，仍未就绪时在 futex 上休眠（Linux），
+ * 其他平台退化为自旋后 sched_yield。
+ *
+ * 状态：0 = 未就绪且无人休眠，1 = 已就绪，2 = 未就绪且有线程在休眠（发布时需要唤醒）。
+ * 每个标志独占一个缓存行，并记录发布时刻，用于测量线程间传递的延迟。
+ */
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+#include <sched.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define RF_CPU_RELAX() _mm_pause()
+#elif defined(__aarch64__)
+#define RF_CPU_RELAX() __asm__ __volatile__("yield")
+#else
+#define RF_CPU_RELAX() ((void)0)
+#endif
+
+#define RF_SPIN_LIMIT 2000
+
+typedef struct {
+    _Alignas(64) atomic_int state;
+    uint64_t publish_ns;     // 发布时刻（CLOCK_MONOTONIC，纳秒），在 release 写之前写入
+} ready_flag_t;
+
+static inline uint64_t rf_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static inline void rf_init(ready_flag_t *f) {
+    atomic_init(&f->state, 0);
+    f->publish_ns = 0;
+}
+
+#ifdef __linux__
+static inline void rf_futex_wait(atomic_int *addr, int expected) {
+    syscall(SYS_futex, (int *)addr, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+static inline void rf_futex_wake_all(atomic_int *addr) {
+    syscall(SYS_futex, (int *)addr, FUTEX_WAKE_PRIVATE, INT32_MAX, NULL, NULL, 0);
+}
+#endif
+
+// 发布：记录时刻后以 release 语义置为就绪，有线程休眠时唤醒它们
+static inline void rf_publish(ready_flag_t *f) {
+    f->publish_ns = rf_now_ns();
+    int old = atomic_exchange_explicit(&f->state, 1, memory_order_release);
+#ifdef __linux__
+    if (old == 2) rf_futex_wake_all(&f->state);
+#else
+    (void)old;
+#endif
+}
+
+// 从发布到此刻的延迟（纳秒），调用者已用 acquire 读到就绪
+static inline uint64_t rf_latency(const ready_flag_t *f) {
+    uint64_t now = rf_now_ns();
+    return now > f->publish_ns ? now - f->publish_ns : 0;
+}
+
+// 等待就绪（acquire），返回从发布到本线程观察到就绪的延迟（纳秒）
+static inline uint64_t rf_wait(ready_flag_t *f) {
+    for (int i = 0; i < RF_SPIN_LIMIT; ++i) {
+        if (atomic_load_explicit(&f->state, memory_order_acquire) == 1)
+            goto ready;
+        RF_CPU_RELAX();
+    }
+    for (;;) {
+        int s = atomic_load_explicit(&f->state, memory_order_acquire);
+        if (s == 1) break;
+#ifdef __linux__
+        if (s == 0 && !atomic_compare_exchange_strong_explicit(&f->state, &s, 2,
+                                                               memory_order_acquire, memory_order_acquire))
+            continue;        // s 已被更新，重新判断
+        rf_futex_wait(&f->state, 2);
+#else
+        sched_yield();
+#endif
+    }
+ready:
+    return rf_latency(f);
+}
+
+/*
+ * 同时等待两个标志，*lat0 / *lat1 为各自从发布到本线程首次观察到就绪的延迟（纳秒）。
+ * 两个都未就绪时轮询两者（先自旋，超过 RF_SPIN_LIMIT 次后每轮 sched_yield），
+ * 不在其中一个上休眠，先到的标志不会被记入等待另一个的时间；只剩一个时与 rf_wait 相同。
+ */
+static inline void rf_wait2(ready_flag_t *f0, ready_flag_t *f1, uint64_t *lat0, uint64_t *lat1) {
+    int seen0 = 0, seen1 = 0;
+    for (int i = 0;; ++i) {
+        if (!seen0 && atomic_load_explicit(&f0->state, memory_order_acquire) == 1) {
+            *lat0 = rf_latency(f0);
+            seen0 = 1;
+        }
+        if (!seen1 && atomic_load_explicit(&f1->state, memory_order_acquire) == 1) {
+            *lat1 = rf_latency(f1);
+            seen1 = 1;
+        }
+        if (seen0 && seen1) return;
+        if (seen0) { *lat1 = rf_wait(f1); return; }
+        if (seen1) { *lat0 = rf_wait(f0); return; }
+        if (i < RF_SPIN_LIMIT) RF_CPU_RELAX();
+        else sched_yield();
+    }
+}
+
+#endif
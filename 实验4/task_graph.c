@@ -0,0 +1,285 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include "task_graph.h"
+
+#define TG_SPIN_BEFORE_YIELD 64
+#define TG_IDLE_YIELDS 4096     // 两次执行之间空闲线程先让出 CPU 若干次，再在条件变量上休眠
+
+typedef struct {
+    tg_fn fn;
+    void *arg;
+    int num_deps;            // 前驱个数
+    int *succ;               // 后继节点编号
+    int num_succ, cap_succ;
+    atomic_int pending;      // 本次执行中尚未完成的前驱个数
+} tg_node_t;
+
+/* Vyukov 有界 MPMC 队列的一个槽位：seq 表示该槽位当前可入队/出队的序号 */
+typedef struct {
+    atomic_size_t seq;
+    int value;
+} tg_cell_t;
+
+struct tg_graph {
+    tg_node_t *nodes;
+    int num_nodes, cap_nodes;
+
+    tg_cell_t *cells;
+    size_t mask;             // 队列容量 - 1（容量为 2 的幂）
+    _Alignas(64) atomic_size_t enq_pos;
+    _Alignas(64) atomic_size_t deq_pos;
+    _Alignas(64) atomic_int remaining;   // 本次执行中尚未完成的节点数
+    atomic_int finished;                 // 本次执行中已退出执行循环的工作线程数
+    atomic_int generation;               // 每次 tg_run 加一，唤醒工作线程
+    atomic_int shutdown;
+    int validated;           // 图结构自上次检查以来未改变且无环
+
+    pthread_t *workers;
+    int num_workers;
+    pthread_mutex_t mtx;
+    pthread_cond_t cv_run;
+    int parked;              // 在条件变量上休眠的工作线程数
+};
+
+/* ---------------- 无锁队列 ---------------- */
+
+static int tg_queue_init(tg_graph_t *g, size_t min_cap) {
+    size_t cap = 2;
+    while (cap < min_cap) cap <<= 1;
+    free(g->cells);
+    g->cells = malloc(sizeof(tg_cell_t) * cap);
+    if (!g->cells) return -1;
+    for (size_t i = 0; i < cap; ++i) atomic_init(&g->cells[i].seq, i);
+    g->mask = cap - 1;
+    atomic_store(&g->enq_pos, 0);
+    atomic_store(&g->deq_pos, 0);
+    return 0;
+}
+
+static int tg_push(tg_graph_t *g, int value) {
+    size_t pos = atomic_load_explicit(&g->enq_pos, memory_order_relaxed);
+    tg_cell_t *cell;
+    for (;;) {
+        cell = &g->cells[pos & g->mask];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&g->enq_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            return 0;        // 队列满（容量不小于节点数，正常情况下不会发生）
+        } else {
+            pos = atomic_load_explicit(&g->enq_pos, memory_order_relaxed);
+        }
+    }
+    cell->value = value;
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+    return 1;
+}
+
+static int tg_pop(tg_graph_t *g, int *value) {
+    size_t pos = atomic_load_explicit(&g->deq_pos, memory_order_relaxed);
+    tg_cell_t *cell;
+    for (;;) {
+        cell = &g->cells[pos & g->mask];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&g->deq_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            return 0;        // 队列空
+        } else {
+            pos = atomic_load_explicit(&g->deq_pos, memory_order_relaxed);
+        }
+    }
+    *value = cell->value;
+    atomic_store_explicit(&cell->seq, pos + g->mask + 1, memory_order_release);
+    return 1;
+}
+
+/* ---------------- 执行 ---------------- */
+
+// 执行一个节点，并把因此变为就绪的后继入队
+static void tg_execute(tg_graph_t *g, int id) {
+    tg_node_t *n = &g->nodes[id];
+    n->fn(n->arg);
+    for (int s = 0; s < n->num_succ; ++s) {
+        tg_node_t *succ = &g->nodes[n->succ[s]];
+        // acq_rel：前驱写入的数据对后继可见
+        if (atomic_fetch_sub_explicit(&succ->pending, 1, memory_order_acq_rel) == 1)
+            tg_push(g, n->succ[s]);
+    }
+    atomic_fetch_sub_explicit(&g->remaining, 1, memory_order_acq_rel);
+}
+
+// 不断取就绪节点执行，直到本次执行的所有节点完成
+static void tg_drain(tg_graph_t *g) {
+    int spins = 0, id;
+    while (atomic_load_explicit(&g->remaining, memory_order_acquire) > 0) {
+        if (tg_pop(g, &id)) {
+            tg_execute(g, id);
+            spins = 0;
+        } else if (++spins >= TG_SPIN_BEFORE_YIELD) {
+            sched_yield();
+            spins = 0;
+        }
+    }
+}
+
+static void *tg_worker(void *p) {
+    tg_graph_t *g = (tg_graph_t *)p;
+    int seen = 0;
+    for (;;) {
+        // 先让出 CPU 等待下一次执行，等待过久再休眠，使连续执行的延迟保持在微秒级
+        int idle = 0;
+        while (atomic_load_explicit(&g->generation, memory_order_acquire) == seen &&
+               !atomic_load(&g->shutdown)) {
+            if (++idle < TG_IDLE_YIELDS) {
+                sched_yield();
+                continue;
+            }
+            pthread_mutex_lock(&g->mtx);
+            g->parked++;
+            while (atomic_load(&g->generation) == seen && !atomic_load(&g->shutdown))
+                pthread_cond_wait(&g->cv_run, &g->mtx);
+            g->parked--;
+            pthread_mutex_unlock(&g->mtx);
+        }
+        if (atomic_load(&g->shutdown)) break;
+        seen = atomic_load_explicit(&g->generation, memory_order_acquire);
+
+        tg_drain(g);
+        atomic_fetch_add_explicit(&g->finished, 1, memory_order_release);
+    }
+    return NULL;
+}
+
+// Kahn 拓扑排序检查图中是否有环
+static int tg_validate(tg_graph_t *g) {
+    int n = g->num_nodes, head = 0, tail = 0;
+    int *deg = malloc(sizeof(int) * n), *order = malloc(sizeof(int) * n);
+    if (!deg || !order) { free(deg); free(order); return -1; }
+    for (int i = 0; i < n; ++i) {
+        deg[i] = g->nodes[i].num_deps;
+        if (deg[i] == 0) order[tail++] = i;
+    }
+    while (head < tail) {
+        tg_node_t *v = &g->nodes[order[head++]];
+        for (int s = 0; s < v->num_succ; ++s)
+            if (--deg[v->succ[s]] == 0) order[tail++] = v->succ[s];
+    }
+    free(deg);
+    free(order);
+    return tail == n ? 0 : -1;
+}
+
+tg_graph_t *tg_create(int num_workers) {
+    tg_graph_t *g = NULL;
+    // 结构体内含按缓存行对齐的成员，需按 64 字节对齐分配
+    if (posix_memalign((void **)&g, 64, sizeof(tg_graph_t)) != 0) return NULL;
+    memset(g, 0, sizeof(tg_graph_t));
+    if (num_workers < 0) num_workers = 0;
+    pthread_mutex_init(&g->mtx, NULL);
+    pthread_cond_init(&g->cv_run, NULL);
+    atomic_init(&g->remaining, 0);
+    atomic_init(&g->finished, 0);
+    atomic_init(&g->generation, 0);
+    atomic_init(&g->shutdown, 0);
+    g->workers = malloc(sizeof(pthread_t) * (num_workers > 0 ? num_workers : 1));
+    for (int t = 0; t < num_workers; ++t) {
+        if (pthread_create(&g->workers[t], NULL, tg_worker, g) != 0) break;
+        g->num_workers++;
+    }
+    return g;
+}
+
+int tg_add_node(tg_graph_t *g, tg_fn fn, void *arg) {
+    if (g->num_nodes == g->cap_nodes) {
+        int cap = g->cap_nodes ? g->cap_nodes * 2 : 16;
+        tg_node_t *p = realloc(g->nodes, sizeof(tg_node_t) * cap);
+        if (!p) return -1;
+        g->nodes = p;
+        g->cap_nodes = cap;
+    }
+    tg_node_t *n = &g->nodes[g->num_nodes];
+    n->fn = fn;
+    n->arg = arg;
+    n->num_deps = 0;
+    n->succ = NULL;
+    n->num_succ = n->cap_succ = 0;
+    atomic_init(&n->pending, 0);
+    g->validated = 0;
+    return g->num_nodes++;
+}
+
+int tg_add_dep(tg_graph_t *g, int node, int depends_on) {
+    if (node < 0 || node >= g->num_nodes || depends_on < 0 || depends_on >= g->num_nodes || node == depends_on)
+        return -1;
+    tg_node_t *d = &g->nodes[depends_on];
+    if (d->num_succ == d->cap_succ) {
+        int cap = d->cap_succ ? d->cap_succ * 2 : 4;
+        int *p = realloc(d->succ, sizeof(int) * cap);
+        if (!p) return -1;
+        d->succ = p;
+        d->cap_succ = cap;
+    }
+    d->succ[d->num_succ++] = node;
+    g->nodes[node].num_deps++;
+    g->validated = 0;
+    return 0;
+}
+
+int tg_run(tg_graph_t *g) {
+    if (g->num_nodes == 0) return 0;
+    if (!g->validated) {
+        if (tg_validate(g) != 0) return -1;   // 有环
+        if ((size_t)g->num_nodes > (g->cells ? g->mask + 1 : 0) && tg_queue_init(g, g->num_nodes) != 0)
+            return -1;
+        g->validated = 1;
+    }
+
+    // 重置计数并把无依赖的节点入队
+    for (int i = 0; i < g->num_nodes; ++i)
+        atomic_store_explicit(&g->nodes[i].pending, g->nodes[i].num_deps, memory_order_relaxed);
+    atomic_store_explicit(&g->finished, 0, memory_order_relaxed);
+    atomic_store_explicit(&g->remaining, g->num_nodes, memory_order_release);
+    for (int i = 0; i < g->num_nodes; ++i)
+        if (g->nodes[i].num_deps == 0) tg_push(g, i);
+
+    if (g->num_workers > 0) {
+        pthread_mutex_lock(&g->mtx);
+        atomic_fetch_add_explicit(&g->generation, 1, memory_order_release);
+        if (g->parked > 0) pthread_cond_broadcast(&g->cv_run);
+        pthread_mutex_unlock(&g->mtx);
+    }
+    tg_drain(g);
+
+    // 等待所有工作线程离开本次执行循环，之后才能安全地开始下一次执行或修改图
+    while (atomic_load_explicit(&g->finished, memory_order_acquire) < g->num_workers)
+        sched_yield();
+    return 0;
+}
+
+void tg_destroy(tg_graph_t *g) {
+    if (!g) return;
+    pthread_mutex_lock(&g->mtx);
+    atomic_store(&g->shutdown, 1);
+    pthread_cond_broadcast(&g->cv_run);
+    pthread_mutex_unlock(&g->mtx);
+    for (int t = 0; t < g->num_workers; ++t) pthread_join(g->workers[t], NULL);
+    for (int i = 0; i < g->num_nodes; ++i) free(g->nodes[i].succ);
+    free(g->nodes);
+    free(g->cells);
+    free(g->workers);
+    pthread_mutex_destroy(&g->mtx);
+    pthread_cond_destroy(&g->cv_run);
+    free(g);
+}
@@ -0,0 +1,33 @@
+#ifndef TASK_GRAPH_H
+#define TASK_GRAPH_H
+
+/*
+ * 小型任务图（DAG）执行器。
+ *
+ * 节点通过 tg_add_dep 声明依赖；tg_run 执行整个图一次：
+ *   - 每个节点持有原子的剩余依赖计数，前驱完成时原子减一，减到 0 即变为就绪；
+ *   - 就绪节点进入无锁的有界 MPMC 队列，由创建时启动的固定工作线程池取出执行；
+ *   - 调用 tg_run 的线程也参与执行，全部节点完成后返回。
+ * 同一个图可以反复执行（每次 tg_run 都会重置依赖计数），工作线程在两次执行之间休眠。
+ * 图的结构（加节点、加依赖）只能在没有 tg_run 正在进行时修改。
+ */
+
+typedef void (*tg_fn)(void *arg);
+
+typedef struct tg_graph tg_graph_t;
+
+// num_workers 为额外的工作线程数（可以为 0，此时由调用 tg_run 的线程串行执行）
+tg_graph_t *tg_create(int num_workers);
+
+// 返回节点编号，失败返回 -1
+int tg_add_node(tg_graph_t *g, tg_fn fn, void *arg);
+
+// 声明 node 依赖 depends_on（depends_on 完成后 node 才能执行），成功返回 0
+int tg_add_dep(tg_graph_t *g, int node, int depends_on);
+
+// 执行整个图一次，阻塞直到所有节点完成；图中有环时返回 -1
+int tg_run(tg_graph_t *g);
+
+void tg_destroy(tg_graph_t *g);
+
+#endif
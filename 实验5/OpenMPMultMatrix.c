@@ -3,19 +3,68 @@
 #include <string.h>
 #include <time.h>
 #include <omp.h>
+#include "../common/counter_rng.h"
+#include "../common/matrix_arena.h"
+#include "../common/freivalds.h"
+#include "../common/autotune.h"
+#include "../common/gemm.h"
 
-static void fill_random(double *mat, int rows, int cols)
+/* Counter-based fill: element i only depends on (seed, stream, i), so the
+   result is identical for any thread count and schedule. */
+static void fill_random(double *mat, int rows, int cols,
+                        uint64_t seed, uint64_t stream)
 {
-    for (long long i = 0; i < (long long)rows * cols; ++i)
-        mat[i] = (double)rand() / RAND_MAX;          /* [0,1) */
+    const long long total = (long long)rows * cols;
+    const long long block = 4096;
+    const uint64_t key = crng_key(seed, stream);
+
+    #pragma omp parallel for schedule(static)
+    for (long long b = 0; b < total; b += block) {
+        long long e = (b + block < total) ? b + block : total;
+        crng_fill_uniform(mat + b, b, e, key, 0.0, 1.0);   /* [0,1) */
+    }
 }
 
-static void multiply_omp(const double *A, const double *B, double *C,
-                         int m, int n, int k,
+#define TILE    64      /* default C tile edge for the tiled / task variants */
+
+/* All variants compute the full GEMM C = alpha*op(A)*op(B) + beta*C on the
+   row-major description g (common/gemm.h); op(A)(i,p) = A[i*a_rs + p*a_cs]. */
+
+/* Recursive blocking: halve the larger side of the C block and run the two
+   halves as a two-iteration taskloop until the block is a single tile. */
+static void multiply_rec(const gemm_f64_t *g, int tile, int i0, int i1, int j0, int j1)
+{
+    if (i1 - i0 <= tile && j1 - j0 <= tile) {
+        gemm_f64_block(g, i0, i1, j0, j1);
+        return;
+    }
+    const int split_rows = (i1 - i0) >= (j1 - j0);
+    const int mid = split_rows ? (i0 + i1) / 2 : (j0 + j1) / 2;
+    #pragma omp taskloop grainsize(1)
+    for (int h = 0; h < 2; ++h) {
+        if (split_rows)
+            multiply_rec(g, tile, h ? mid : i0, h ? i1 : mid, j0, j1);
+        else
+            multiply_rec(g, tile, i0, i1, h ? mid : j0, h ? j1 : mid);
+    }
+}
+
+/* beta*C term; beta == 0 must not read C (BLAS semantics) */
+static inline double scaled_c(const gemm_f64_t *g, int i, int j)
+{
+    return g->beta == 0.0 ? 0.0 : g->beta * g->C[i * (long long)g->ldc + j];
+}
+
+static void multiply_omp(const gemm_f64_t *g,
                          int num_threads,
+                         const char *variant,    /* "rows" | "tiles" | "simd" | "taskloop" */
                          const char *sched,      /* "default" | "static" | "dynamic" */
-                         int chunk)              /* chunk size for static/dynamic */
+                         int chunk,              /* chunk size for static/dynamic */
+                         int tile,               /* C tile edge for tiles/taskloop */
+                         double *work)           /* K*N scratch for the simd variant */
 {
+    const int m = g->M, n = g->N, k = g->K;
+
     /* Configure threads and (optionally) schedule policy */
     omp_set_num_threads(num_threads);
 
@@ -26,40 +75,146 @@ static void multiply_omp(const double *A, const double *B, double *C,
         omp_set_schedule(stype, chunk);
     }
 
-    /* Parallelised i‑loop; inner loops are private per thread */
-    #pragma omp parallel for schedule(runtime)
-    for (int i = 0; i < m; ++i) {
-        for (int j = 0; j < k; ++j) {
-            double sum = 0.0;
-            for (int p = 0; p < n; ++p)
-                sum += A[i * (long long)n + p] * B[p * (long long)k + j];
-            C[i * (long long)k + j] = sum;
+    if (strcmp(variant, "tiles") == 0) {
+        /* Both tile loops collapsed into one iteration space of tile x tile blocks */
+        const int tm = (m + tile - 1) / tile, tn = (n + tile - 1) / tile;
+        #pragma omp parallel for collapse(2) schedule(runtime)
+        for (int ti = 0; ti < tm; ++ti) {
+            for (int tj = 0; tj < tn; ++tj) {
+                const int i0 = ti * tile, j0 = tj * tile;
+                gemm_f64_block(g, i0, (i0 + tile < m) ? i0 + tile : m,
+                               j0, (j0 + tile < n) ? j0 + tile : n);
+            }
+        }
+    } else if (strcmp(variant, "simd") == 0) {
+        /* Pack op(B) transposed so each dot product reads op(B) with unit stride */
+        double *BT = work;
+        #pragma omp parallel
+        {
+            #pragma omp for schedule(static)
+            for (int j = 0; j < n; ++j)
+                for (int p = 0; p < k; ++p)
+                    BT[j * (long long)k + p] = g->B[p * (long long)g->b_rs + j * (long long)g->b_cs];
+
+            #pragma omp for schedule(runtime)
+            for (int i = 0; i < m; ++i) {
+                const double *a = g->A + i * (long long)g->a_rs;
+                for (int j = 0; j < n; ++j) {
+                    const double *bt = BT + j * (long long)k;
+                    double sum = 0.0;
+                    if (g->a_cs == 1) {
+                        #pragma omp simd reduction(+:sum)
+                        for (int p = 0; p < k; ++p)
+                            sum += a[p] * bt[p];
+                    } else {
+                        for (int p = 0; p < k; ++p)
+                            sum += a[p * (long long)g->a_cs] * bt[p];
+                    }
+                    g->C[i * (long long)g->ldc + j] = g->alpha * sum + scaled_c(g, i, j);
+                }
+            }
+        }
+    } else if (strcmp(variant, "taskloop") == 0) {
+        /* Tasks are load-balanced by the runtime; the loop schedule does not apply */
+        #pragma omp parallel
+        #pragma omp single
+        multiply_rec(g, tile, 0, m, 0, n);
+    } else {
+        /* Parallelised i‑loop; inner loops are private per thread */
+        #pragma omp parallel for schedule(runtime)
+        for (int i = 0; i < m; ++i) {
+            for (int j = 0; j < n; ++j) {
+                double sum = 0.0;
+                for (int p = 0; p < k; ++p)
+                    sum += g->A[i * (long long)g->a_rs + p * (long long)g->a_cs]
+                         * g->B[p * (long long)g->b_rs + j * (long long)g->b_cs];
+                g->C[i * (long long)g->ldc + j] = g->alpha * sum + scaled_c(g, i, j);
+            }
         }
     }
 }
 
-static double run_case(int m, int n, int k,
-                       int threads, const char *sched)
+/* Full GEMM with the cblas_dgemm argument list; work is a K*N scratch for the
+   simd variant (allocated here when NULL). Returns -1 on invalid arguments. */
+static int omp_dgemm(gemm_order_t order, gemm_trans_t ta, gemm_trans_t tb,
+                     int M, int N, int K, double alpha, const double *A, size_t lda,
+                     const double *B, size_t ldb, double beta, double *C, size_t ldc,
+                     int num_threads, const char *variant, const char *sched,
+                     int chunk, int tile, double *work)
 {
-    double *A = (double *)malloc(sizeof(double) * (long long)m * n);
-    double *B = (double *)malloc(sizeof(double) * (long long)n * k);
-    double *C = (double *)calloc((long long)m * k, sizeof(double));
-    if (!A || !B || !C) {
-        fprintf(stderr, "Memory allocation failed\n");
+    gemm_f64_t g;
+    if (gemm_f64_setup(&g, order, ta, tb, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc) != 0)
+        return -1;
+    double *owned = NULL;
+    if (!work && strcmp(variant, "simd") == 0) {
+        const long long elems = (long long)g.K * g.N;    /* after the column-major swap */
+        owned = (double *)malloc(sizeof(double) * (elems > 0 ? elems : 1));
+        if (!owned) return -1;
+        work = owned;
+    }
+    multiply_omp(&g, num_threads, variant, sched, chunk, tile, work);
+    free(owned);
+    return 0;
+}
+
+/* GEMM interface self-test callback: ctx is the variant name, 4 threads */
+static void selftest_dgemm(gemm_order_t order, gemm_trans_t ta, gemm_trans_t tb,
+                           int M, int N, int K, double alpha, const double *A, size_t lda,
+                           const double *B, size_t ldb, double beta, double *C, size_t ldc,
+                           void *ctx)
+{
+    omp_dgemm(order, ta, tb, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc,
+              4, (const char *)ctx, "static", 8, 16, NULL);
+}
+
+/* All matrices of a case are views into one arena mapped for the largest size,
+   so no case pays for page faults or zeroing inside (or around) its timing. */
+static double run_case(mat_arena_t *arena, int m, int n, int k, int threads,
+                       const char *variant, const char *sched, int chunk, int tile,
+                       uint64_t seed, int fv_trials, double *residual)
+{
+    arena_reset(arena);
+    double *A = (double *)arena_alloc(arena, sizeof(double) * (long long)m * n);
+    double *B = (double *)arena_alloc(arena, sizeof(double) * (long long)n * k);
+    double *C = (double *)arena_alloc(arena, sizeof(double) * (long long)m * k);
+    double *W = (double *)arena_alloc(arena, sizeof(double) * (long long)n * k);
+    if (!A || !B || !C || !W) {
+        fprintf(stderr, "Arena too small\n");
         exit(EXIT_FAILURE);
     }
 
-    fill_random(A, m, n);
-    fill_random(B, n, k);
+    fill_random(A, m, n, seed, 0);
+    fill_random(B, n, k, seed, 1);
 
+    /* C = A * B: A is m x n, B is n x k, so BLAS M = m, N = k, K = n */
     const double t0 = omp_get_wtime();
-    multiply_omp(A, B, C, m, n, k, threads, sched, 32);
+    omp_dgemm(GEMM_ROW_MAJOR, GEMM_NO_TRANS, GEMM_NO_TRANS, m, k, n,
+              1.0, A, n, B, k, 0.0, C, k, threads, variant, sched, chunk, tile, W);
     const double t1 = omp_get_wtime();
 
-    free(A); free(B); free(C);
+    /* Freivalds check outside the timed region: O(n^2) per random vector */
+    *residual = fv_check_rows_f64(A, B, C, m, n, k, fv_trials, seed);
     return t1 - t0;
 }
 
+/* Auto-tuning of the tiled variant: thread count, loop schedule, chunk and
+   tile edge, searched per size and cached per CPU model (common/autotune.c). */
+static const char *tune_sched_names[] = { "static", "dynamic", "guided" };
+
+typedef struct {
+    mat_arena_t *arena;
+    int m, n, k;
+    uint64_t seed;
+} TuneCtx;
+
+static double tune_measure(const at_config_t *cfg, void *p)
+{
+    const TuneCtx *c = (const TuneCtx *)p;
+    double residual;
+    return run_case(c->arena, c->m, c->n, c->k, cfg->v[0], "tiles",
+                    tune_sched_names[cfg->v[1]], cfg->v[2], cfg->v[3], c->seed, 1, &residual);
+}
+
 int main(void)
 {
     const int dims[] = {128, 256, 512, 1024, 2048};
@@ -68,26 +223,91 @@ int main(void)
     const size_t nthreads = sizeof(threads) / sizeof(threads[0]);
     const char *schedules[] = { "default", "static", "dynamic" };
     const size_t nsched = sizeof(schedules) / sizeof(schedules[0]);
+    const char *variants[] = { "rows", "tiles", "simd", "taskloop" };
+    const size_t nvariants = sizeof(variants) / sizeof(variants[0]);
+
+    /* Fixed seed (override with RNG_SEED) so every run sees the same matrices */
+    const uint64_t seed = crng_seed_from_env(CRNG_DEFAULT_SEED);
+    const int fv_trials = fv_trials_for(fv_false_positive_from_env());
+
+    /* One arena for A, B, C and the scratch matrix at the largest size; pages are
+       first touched by the OpenMP threads (static split) before any timing */
+    const long long maxd = dims[ndims - 1];
+    mat_arena_t arena;
+    if (arena_init(&arena, 4 * (sizeof(double) * maxd * maxd + ARENA_ALIGN),
+                   arena_flags_from_env()) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return EXIT_FAILURE;
+    }
+    omp_set_num_threads(threads[nthreads - 1]);
+    #pragma omp parallel
+    arena_touch(&arena, omp_get_thread_num(), omp_get_num_threads());
+    printf("Pages: %s (set ARENA_PAGES=4k|thp|2m|1g)\n", arena_backing_name(&arena));
+    printf("CPU: %s\n", at_cpu_model());
+
+    /* Full GEMM interface (row/column major, transposes, strides, alpha/beta)
+       of every variant against an element-wise reference */
+    for (size_t vi = 0; vi < nvariants; ++vi) {
+        const double err = gemm_selftest_f64(selftest_dgemm, (void *)variants[vi]);
+        printf("GEMM self-test %-9s max rel. error %.2e  %s\n", variants[vi], err,
+               (err >= 0.0 && err < 1e-12) ? "PASS" : "FAIL");
+    }
+    printf("\n");
 
-    /* Seed RNG once */
-    srand((unsigned)time(NULL));
+    /* Candidate values; the first of each is the search starting point */
+    static const int tune_threads[] = {16, 8, 4, 2, 1};
+    static const int tune_sched[]   = {0, 1, 2};
+    static const int tune_chunk[]   = {32, 1, 4, 8, 16, 64};
+    static const int tune_tile[]    = {TILE, 32, 128};
+    const at_param_t tune_params[] = {
+        { "threads",  tune_threads, 5 },
+        { "schedule", tune_sched,   3 },
+        { "chunk",    tune_chunk,   6 },
+        { "tile",     tune_tile,    3 },
+    };
 
     for (size_t di = 0; di < ndims; ++di) {
         int m = dims[di];
         int n = dims[di];
         int k = dims[di];
         printf("m=%d, n=%d, k=%d\n", m, n, k);
+
+        /* Tuned configuration for this size: loaded from the cache or searched now.
+           Its chunk and tile are also used for the schedule sweep below. */
+        TuneCtx tctx = { &arena, m, n, k, seed };
+        at_config_t tuned;
+        int from = at_tune("omp_matmul_tiles", m, tune_params, 4, tune_measure, &tctx, &tuned);
+        const int chunk = tuned.v[2], tile = tuned.v[3];
+        printf("Tuned (%s): threads=%d schedule=%s chunk=%d tile=%d\n",
+               from == 1 ? "cache" : from == 0 ? "search" : "default",
+               tuned.v[0], tune_sched_names[tuned.v[1]], chunk, tile);
         printf("---------------------------------------------------------------\n");
-        printf("%8s %9s %12s\n", "Threads", "Schedule", "Time(s)");
+        printf("%9s %8s %9s %12s %10s\n", "Variant", "Threads", "Schedule", "Time(s)", "Check");
         printf("---------------------------------------------------------------\n");
-        for (size_t si = 0; si < nsched; ++si) {
-            for (size_t ti = 0; ti < nthreads; ++ti) {
-                double t = run_case(m, n, k, threads[ti], schedules[si]);
-                printf("%8d %9s %12.6f\n", threads[ti], schedules[si], t);
+        for (size_t vi = 0; vi < nvariants; ++vi) {
+            /* taskloop ignores the loop schedule, so it is measured once */
+            const int is_task = strcmp(variants[vi], "taskloop") == 0;
+            for (size_t si = 0; si < (is_task ? 1 : nsched); ++si) {
+                for (size_t ti = 0; ti < nthreads; ++ti) {
+                    double residual;
+                    double t = run_case(&arena, m, n, k, threads[ti], variants[vi], schedules[si],
+                                        chunk, tile, seed, fv_trials, &residual);
+                    printf("%9s %8d %9s %12.6f %10s\n", variants[vi], threads[ti],
+                           is_task ? "tasks" : schedules[si], t,
+                           (residual >= 0.0 && residual <= 1.0) ? "PASS" : "FAIL");
+                }
             }
         }
+        {
+            double residual;
+            double t = run_case(&arena, m, n, k, tuned.v[0], "tiles", tune_sched_names[tuned.v[1]],
+                                chunk, tile, seed, fv_trials, &residual);
+            printf("%9s %8d %9s %12.6f %10s\n", "tuned", tuned.v[0], tune_sched_names[tuned.v[1]], t,
+                   (residual >= 0.0 && residual <= 1.0) ? "PASS" : "FAIL");
+        }
         printf("\n");
     }
 
+    arena_destroy(&arena);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <omp.h>
+#include "../common/counter_rng.h"
+#include "../common/sparse.h"
+
+/* Sparse kernels (common/sparse.c) under OpenMP: SpMV y = A x and SpMM C = A B
+   (B dense with a few columns) for CSR and SELL-C-sigma, with the rows (chunks)
+   split into blocks either by equal row count or by equal nonzero count. */
+
+#define BLOCKS_PER_THREAD 8     /* blocks dealt round-robin in the cyclic split */
+#define MIN_TIME 0.05           /* each case repeats until this much time has passed */
+
+typedef struct {
+    const char *name;
+    int by_nnz;                 /* split on the nonzero prefix instead of row count */
+    int cyclic;                 /* BLOCKS_PER_THREAD blocks per thread, dealt round-robin */
+} Split;
+
+static const Split splits[] = {
+    { "rows-block", 0, 0 },     /* the original equal-row block distribution */
+    { "nnz-block",  1, 0 },
+    { "nnz-cyclic", 1, 1 },
+};
+
+typedef struct {
+    csr_t A;
+    sell_t S;
+    int ncols;
+    double *x, *y, *B, *C;
+} Problem;
+
+/* One block of rows (CSR) or chunks (SELL) */
+static void run_block(const Problem *pr, int sell, int spmm, int lo, int hi)
+{
+    if (!sell) {
+        if (spmm) csr_spmm(&pr->A, pr->B, pr->ncols, pr->ncols, pr->C, pr->ncols, lo, hi);
+        else      csr_spmv(&pr->A, pr->x, pr->y, lo, hi);
+    } else {
+        if (spmm) sell_spmm(&pr->S, pr->B, pr->ncols, pr->ncols, pr->C, pr->ncols, lo, hi);
+        else      sell_spmv(&pr->S, pr->x, pr->y, lo, hi);
+    }
+}
+
+/* Mean time per call; thread p runs blocks p, p + P, ... of the split */
+static double time_case(const Problem *pr, int sell, int spmm,
+                        const int *bounds, int nblocks, int threads)
+{
+    int reps = 0;
+    const double t0 = omp_get_wtime();
+    double t1;
+    do {
+        #pragma omp parallel num_threads(threads)
+        {
+            const int p = omp_get_thread_num(), P = omp_get_num_threads();
+            for (int b = p; b < nblocks; b += P)
+                run_block(pr, sell, spmm, bounds[b], bounds[b + 1]);
+        }
+        ++reps;
+        t1 = omp_get_wtime();
+    } while (t1 - t0 < MIN_TIME);
+    return (t1 - t0) / reps;
+}
+
+/* max |out - ref| / max |ref| */
+static double rel_error(const double *out, const double *ref, long long n)
+{
+    double err = 0.0, scale = 0.0;
+    for (long long i = 0; i < n; ++i) {
+        const double d = fabs(out[i] - ref[i]);
+        if (!(d <= err)) err = d;
+        if (fabs(ref[i]) > scale) scale = fabs(ref[i]);
+    }
+    return err / (scale > 0.0 ? scale : 1.0);
+}
+
+int main(int argc, char **argv)
+{
+    const int rows   = argc > 1 ? atoi(argv[1]) : 200000;
+    const double avg = argc > 2 ? atof(argv[2]) : 16.0;
+    const double skew = argc > 3 ? atof(argv[3]) : 0.5;
+    const int ncols  = argc > 4 ? atoi(argv[4]) : 16;
+    const int threads[] = {1, 2, 4, 8, 16};
+    const size_t nthreads = sizeof(threads) / sizeof(threads[0]);
+    const int max_blocks = threads[nthreads - 1] * BLOCKS_PER_THREAD;
+
+    /* Fixed seed (override with RNG_SEED) so every run sees the same matrix */
+    const uint64_t seed = crng_seed_from_env(CRNG_DEFAULT_SEED);
+    sp_gen_t gen;
+    sp_gen_init(&gen, rows, rows, avg, skew, crng_key(seed, 0));
+
+    Problem pr;
+    pr.ncols = ncols;
+    if (csr_generate(&pr.A, &gen, NULL, 0) != 0 ||
+        sell_from_csr(&pr.S, &pr.A, SELL_DEFAULT_C, SELL_DEFAULT_SIGMA) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return EXIT_FAILURE;
+    }
+    const long long nnz = pr.A.nnz;
+    pr.x = malloc(sizeof(double) * rows);
+    pr.y = malloc(sizeof(double) * rows);
+    pr.B = malloc(sizeof(double) * (size_t)rows * ncols);
+    pr.C = malloc(sizeof(double) * (size_t)rows * ncols);
+    double *y_ref = malloc(sizeof(double) * rows);
+    double *C_ref = malloc(sizeof(double) * (size_t)rows * ncols);
+    int *bounds = malloc(sizeof(int) * (max_blocks + 1));
+    if (!pr.x || !pr.y || !pr.B || !pr.C || !y_ref || !C_ref || !bounds) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return EXIT_FAILURE;
+    }
+    crng_fill_uniform(pr.x, 0, rows, crng_key(seed, 1), -1.0, 1.0);
+    crng_fill_uniform(pr.B, 0, (long long)rows * ncols, crng_key(seed, 2), -1.0, 1.0);
+
+    /* Serial CSR results are the reference for every parallel case */
+    csr_spmv(&pr.A, pr.x, y_ref, 0, rows);
+    csr_spmm(&pr.A, pr.B, ncols, ncols, C_ref, ncols, 0, rows);
+
+    const long long stored = pr.S.chunk_ptr[pr.S.nchunks];
+    long long longest = 0;
+    for (int i = 0; i < rows; ++i)
+        if (pr.A.row_ptr[i + 1] - pr.A.row_ptr[i] > longest)
+            longest = pr.A.row_ptr[i + 1] - pr.A.row_ptr[i];
+    printf("rows=%d, nnz=%lld (%.1f per row, longest row %lld), skew=%.2f, SpMM columns=%d\n",
+           rows, nnz, (double)nnz / rows, longest, skew, ncols);
+    printf("Memory: dense %.1f GB, CSR %.1f MB, SELL-%d-%d %.1f MB (%.1f%% of slots are nonzeros)\n\n",
+           8.0 * rows * rows / 1e9, (12.0 * nnz + 8.0 * (rows + 1)) / 1e6,
+           pr.S.C, pr.S.sigma, (12.0 * stored + 4.0 * pr.S.nchunks * pr.S.C) / 1e6,
+           100.0 * nnz / (stored > 0 ? stored : 1));
+
+    for (int spmm = 0; spmm <= 1; ++spmm) {
+        const double flop = 2.0 * nnz * (spmm ? ncols : 1);
+        printf("%s\n", spmm ? "SpMM" : "SpMV");
+        printf("----------------------------------------------------------------------\n");
+        printf("%6s %11s %8s %8s %12s %9s %10s\n",
+               "Format", "Split", "Threads", "Imbal", "Time(s)", "GFLOP/s", "Error");
+        printf("----------------------------------------------------------------------\n");
+        for (int sell = 0; sell <= 1; ++sell) {
+            /* SELL splits whole chunks; its work prefix counts padded slots */
+            const int n = sell ? pr.S.nchunks : rows;
+            const long long *prefix = sell ? pr.S.chunk_ptr : pr.A.row_ptr;
+            for (size_t si = 0; si < sizeof(splits) / sizeof(splits[0]); ++si) {
+                for (size_t ti = 0; ti < nthreads; ++ti) {
+                    const int t = threads[ti];
+                    const int nblocks = splits[si].cyclic ? t * BLOCKS_PER_THREAD : t;
+                    sp_split(splits[si].by_nnz ? prefix : NULL, n, nblocks, bounds);
+                    const double imbal = sp_imbalance(prefix, bounds, nblocks, t);
+
+                    memset(spmm ? pr.C : pr.y, 0,
+                           sizeof(double) * (size_t)rows * (spmm ? ncols : 1));
+                    const double time = time_case(&pr, sell, spmm, bounds, nblocks, t);
+                    const double err = spmm ? rel_error(pr.C, C_ref, (long long)rows * ncols)
+                                            : rel_error(pr.y, y_ref, rows);
+                    printf("%6s %11s %8d %8.2f %12.6f %9.2f %10.2e\n",
+                           sell ? "SELL" : "CSR", splits[si].name, t, imbal,
+                           time, flop / time * 1e-9, err);
+                }
+            }
+        }
+        printf("\n");
+    }
+
+    free(bounds);
+    free(C_ref);
+    free(y_ref);
+    free(pr.C);
+    free(pr.B);
+    free(pr.y);
+    free(pr.x);
+    sell_free(&pr.S);
+    csr_free(&pr.A);
+    return 0;
+}
@@ -1,89 +1,247 @@
 # include <stdlib.h>
 # include <stdio.h>
 # include <math.h>
+# include <string.h>
 # include <omp.h>
 
+#include "../common/matrix_arena.h"
+#include "parallel_for.h"
+
 int thread_counts[] = {1, 2, 4, 8, 16};
 int sizes[]         = {64, 128, 256, 512, 1024};
 int num_threads     = sizeof(thread_counts) / sizeof(thread_counts[0]);
 int num_sizes       = sizeof(sizes) / sizeof(sizes[0]);
 #define IDX(i,j) ((i)*N + (j))
+#define CG_TOL 1e-8   /* PCG stops when ||r||_2 <= CG_TOL * ||r0||_2 */
+
+/* Boundary values (left, right and bottom 100, top 0) and the interior set to
+   their mean, the initial guess of both solvers */
+static void plate_init(double *w, int M, int N)
+{
+  double mean = 0.0;
+#pragma omp parallel for
+  for (int i = 1; i < M-1; i++) w[IDX(i,0)] = 100.0;
+#pragma omp parallel for
+  for (int i = 1; i < M-1; i++) w[IDX(i,N-1)] = 100.0;
+#pragma omp parallel for
+  for (int j = 0; j < N; j++) w[IDX(M-1,j)] = 100.0;
+#pragma omp parallel for
+  for (int j = 0; j < N; j++) w[IDX(0,j)] = 0.0;
+
+#pragma omp parallel for reduction(+ : mean)
+  for (int i = 1; i < M-1; i++) mean += w[IDX(i,0)] + w[IDX(i,N-1)];
+#pragma omp parallel for reduction(+ : mean)
+  for (int j = 0; j < N; j++) mean += w[IDX(0,j)] + w[IDX(M-1,j)];
+  mean /= (2.0 * M + 2.0 * N - 4.0);
+
+#pragma omp parallel for collapse(2)
+  for (int i = 1; i < M-1; i++)
+    for (int j = 1; j < N-1; j++)
+      w[IDX(i,j)] = mean;
+}
+
+/* max over the interior of |w(N) + w(S) + w(W) + w(E) - 4 w|: zero for the exact solution */
+static double plate_residual(const double *w, int M, int N)
+{
+  double res = 0.0;
+#pragma omp parallel for collapse(2) reduction(max : res)
+  for (int i = 1; i < M-1; i++)
+    for (int j = 1; j < N-1; j++) {
+      double d = fabs(w[IDX(i-1,j)] + w[IDX(i+1,j)] + w[IDX(i,j-1)] + w[IDX(i,j+1)] - 4.0*w[IDX(i,j)]);
+      if (d > res) res = d;
+    }
+  return res;
+}
+
+/* Preconditioned conjugate gradient for the same Laplace problem. The unknowns
+   are the interior points of w; boundary values stay fixed and act as the
+   right-hand side. A is the matrix-free 5-point operator 4u - (N + S + W + E)
+   on the interior (r, z, p, q keep a zero boundary). The preconditioner is one
+   symmetric red-black Gauss-Seidel sweep (SPD): z_red = r/4, then the black
+   points, then the red points again from their black neighbours.
+   Every dot product is accumulated in the pass that produces its operands, so
+   an iteration is five parallel regions with three reductions:
+     q = A p with p.q | w += a p, r -= a q with r.r and z_red = r/4 |
+     black z with r.z | red z with r.z | p = z + b p
+   As in the Jacobi loop, threads is an upper bound and the first iteration,
+   run serially, picks the active thread count. */
+static int plate_pcg(double *w, double *r, double *z, double *p, double *q, int M, int N,
+                     int threads, int adaptive, double region_overhead, int procs, int *active_out)
+{
+  int active = adaptive ? 1 : threads;
+  double rr = 0.0, rz = 0.0;
+
+#pragma omp parallel for num_threads(active)
+  for (int i = 0; i < M*N; i++) r[i] = z[i] = p[i] = q[i] = 0.0;
+#pragma omp parallel for collapse(2) reduction(+ : rr) num_threads(active)
+  for (int i = 1; i < M-1; i++)
+    for (int j = 1; j < N-1; j++) {
+      double v = w[IDX(i-1,j)] + w[IDX(i+1,j)] + w[IDX(i,j-1)] + w[IDX(i,j+1)] - 4.0*w[IDX(i,j)];
+      r[IDX(i,j)] = v;
+      rr += v * v;
+      if (((i + j) & 1) == 0) z[IDX(i,j)] = 0.25 * v;
+    }
+  const double stop = CG_TOL * sqrt(rr);
+
+  int iterations = 0;
+  double a, b;
+  for (;;) {
+    double sweep_start = omp_get_wtime();
+    /* preconditioner: black points, then red points; r.z fused into both */
+    double rz_new = 0.0;
+#pragma omp parallel for reduction(+ : rz_new) num_threads(active)
+    for (int i = 1; i < M-1; i++)
+      for (int j = 1 + (i & 1); j < N-1; j += 2) {
+        double v = 0.25 * (r[IDX(i,j)] + z[IDX(i-1,j)] + z[IDX(i+1,j)] + z[IDX(i,j-1)] + z[IDX(i,j+1)]);
+        z[IDX(i,j)] = v;
+        rz_new += r[IDX(i,j)] * v;
+      }
+#pragma omp parallel for reduction(+ : rz_new) num_threads(active)
+    for (int i = 1; i < M-1; i++)
+      for (int j = 1 + ((i + 1) & 1); j < N-1; j += 2) {
+        double v = z[IDX(i,j)] + 0.25 * (z[IDX(i-1,j)] + z[IDX(i+1,j)] + z[IDX(i,j-1)] + z[IDX(i,j+1)]);
+        z[IDX(i,j)] = v;
+        rz_new += r[IDX(i,j)] * v;
+      }
+    if (sqrt(rr) <= stop || rz_new == 0.0) break;
+
+    b = iterations == 0 ? 0.0 : rz_new / rz;
+    rz = rz_new;
+#pragma omp parallel for collapse(2) num_threads(active)
+    for (int i = 1; i < M-1; i++)
+      for (int j = 1; j < N-1; j++)
+        p[IDX(i,j)] = z[IDX(i,j)] + b * p[IDX(i,j)];
+
+    double pq = 0.0;
+#pragma omp parallel for collapse(2) reduction(+ : pq) num_threads(active)
+    for (int i = 1; i < M-1; i++)
+      for (int j = 1; j < N-1; j++) {
+        double v = 4.0*p[IDX(i,j)] - p[IDX(i-1,j)] - p[IDX(i+1,j)] - p[IDX(i,j-1)] - p[IDX(i,j+1)];
+        q[IDX(i,j)] = v;
+        pq += p[IDX(i,j)] * v;
+      }
+    a = rz / pq;
+
+    rr = 0.0;
+#pragma omp parallel for collapse(2) reduction(+ : rr) num_threads(active)
+    for (int i = 1; i < M-1; i++)
+      for (int j = 1; j < N-1; j++) {
+        w[IDX(i,j)] += a * p[IDX(i,j)];
+        double v = r[IDX(i,j)] - a * q[IDX(i,j)];
+        r[IDX(i,j)] = v;
+        rr += v * v;
+        if (((i + j) & 1) == 0) z[IDX(i,j)] = 0.25 * v;
+      }
+    if (adaptive && iterations == 0)
+      active = pf_choose_threads(omp_get_wtime() - sweep_start, 5 * region_overhead,
+                                 threads < procs ? threads : procs);
+    iterations++;
+  }
+  *active_out = active;
+  return iterations;
+}
 
 int main ( int argc, char *argv[] )
 {
   double *u, *w;
   int M, N;
 
+  /* u, w and the four PCG vectors for every case come from one arena sized for the
+     largest grid (ARENA_PAGES=thp|2m|1g backs it with huge pages), first touched by the OpenMP threads */
+  int max_size = sizes[num_sizes - 1];
+  mat_arena_t arena;
+  if (arena_init(&arena, 6 * (sizeof(double) * max_size * max_size + ARENA_ALIGN),
+                 arena_flags_from_env()) != 0) {
+    printf("Memory allocation failed\n");
+    return 1;
+  }
+  omp_set_num_threads(thread_counts[num_threads - 1]);
+#pragma omp parallel
+  arena_touch(&arena, omp_get_thread_num(), omp_get_num_threads());
+  printf("Pages=%s\n", arena_backing_name(&arena));
+
+  /* per-thread cost of opening and closing a parallel region (best of a few
+     empty regions on the full team), used by the thread-count cost model */
+  double region_overhead = 1e9;
+  for (int r = 0; r < 20; r++) {
+      double t0 = omp_get_wtime();
+#pragma omp parallel
+      { }
+      double t = (omp_get_wtime() - t0) / thread_counts[num_threads - 1];
+      if (t < region_overhead) region_overhead = t;
+  }
+  const char *adaptive_env = getenv("PF_ADAPTIVE");
+  int adaptive = !(adaptive_env && strcmp(adaptive_env, "0") == 0);
+  int procs = omp_get_num_procs();
+
   for (int si = 0; si < num_sizes; si++) {
       M = N = sizes[si];
       for (int ti = 0; ti < num_threads; ti++) {
           int threads = thread_counts[ti];
           omp_set_num_threads(threads);
 
-          u = malloc(sizeof(double) * M * N);
-          w = malloc(sizeof(double) * M * N);
-          double mean = 0.0, diff = 0.0, my_diff;
-          int iterations = 0, iterations_print = 1;
+          arena_reset(&arena);
+          u = arena_alloc(&arena, sizeof(double) * M * N);
+          w = arena_alloc(&arena, sizeof(double) * M * N);
+          double diff = 0.0, my_diff;
+          int iterations = 0;
           double wtime;
 
-          // Initialize and set boundaries (convert all w[i][j] to w[IDX(i,j)])
-#pragma omp parallel for
-          for (int i = 1; i < M-1; i++) w[IDX(i,0)] = 100.0;
-#pragma omp parallel for
-          for (int i = 1; i < M-1; i++) w[IDX(i,N-1)] = 100.0;
-#pragma omp parallel for
-          for (int j = 0; j < N; j++) w[IDX(M-1,j)] = 100.0;
-#pragma omp parallel for
-          for (int j = 0; j < N; j++) w[IDX(0,j)] = 0.0;
-
-          // Compute initial mean
-#pragma omp parallel for reduction(+ : mean)
-          for (int i = 1; i < M-1; i++) mean += w[IDX(i,0)] + w[IDX(i,N-1)];
-#pragma omp parallel for reduction(+ : mean)
-          for (int j = 0; j < N; j++) mean += w[IDX(0,j)] + w[IDX(M-1,j)];
-          mean /= (2.0 * M + 2.0 * N - 4.0);
-
-          // Initialize interior
-#pragma omp parallel for collapse(2)
-          for (int i = 1; i < M-1; i++)
-              for (int j = 1; j < N-1; j++)
-                  w[IDX(i,j)] = mean;
+          // Initialize boundaries and set the interior to their mean
+          plate_init(w, M, N);
 
           // Timing start
           wtime = omp_get_wtime();
 
-          // Iteration loop
-          diff = mean; // ensure at least one iteration
-          while (diff >= 0.001) {
+          // Iteration loop. threads is an upper bound: the first sweep runs serially
+          // and its time picks how many threads the three regions per sweep use
+          // (small grids stay serial when fork/join would dominate)
+          int active = adaptive ? 1 : threads;
+          do {
+              double sweep_start = omp_get_wtime();
               // copy w to u
-#pragma omp parallel for collapse(2)
+#pragma omp parallel for collapse(2) num_threads(active)
               for (int i = 0; i < M; i++)
                   for (int j = 0; j < N; j++)
                       u[IDX(i,j)] = w[IDX(i,j)];
 
               // update w
-#pragma omp parallel for collapse(2)
+#pragma omp parallel for collapse(2) num_threads(active)
               for (int i = 1; i < M-1; i++)
                   for (int j = 1; j < N-1; j++)
                       w[IDX(i,j)] = 0.25*(u[IDX(i-1,j)] + u[IDX(i+1,j)] + u[IDX(i,j-1)] + u[IDX(i,j+1)]);
 
               // compute max diff
               diff = 0.0;
-#pragma omp parallel for collapse(2) private(my_diff) reduction(max : diff)
+#pragma omp parallel for collapse(2) private(my_diff) reduction(max : diff) num_threads(active)
               for (int i = 1; i < M-1; i++)
                   for (int j = 1; j < N-1; j++) {
                       my_diff = fabs(w[IDX(i,j)] - u[IDX(i,j)]);
                       if (my_diff > diff) diff = my_diff;
                   }
+              if (adaptive && iterations == 0)
+                  active = pf_choose_threads(omp_get_wtime() - sweep_start, 3 * region_overhead,
+                                             threads < procs ? threads : procs);
               iterations++;
-          }
+          } while (diff >= 0.001);
 
           wtime = omp_get_wtime() - wtime;
-          printf("Size=%d, Threads=%d, Time=%f\n", M, threads, wtime);
+          printf("Size=%d, Threads=%d, Active=%d, Time=%f, Solver=Jacobi, Iterations=%d, Residual=%.2e\n",
+                 M, threads, active, wtime, iterations, plate_residual(w, M, N));
 
-          free(u);
-          free(w);
+          // Same problem and initial guess solved by PCG (w is reused as the solution)
+          double *r = arena_alloc(&arena, sizeof(double) * M * N);
+          double *z = arena_alloc(&arena, sizeof(double) * M * N);
+          double *p = arena_alloc(&arena, sizeof(double) * M * N);
+          double *q = arena_alloc(&arena, sizeof(double) * M * N);
+          plate_init(w, M, N);
+          wtime = omp_get_wtime();
+          iterations = plate_pcg(w, r, z, p, q, M, N, threads, adaptive, region_overhead, procs, &active);
+          wtime = omp_get_wtime() - wtime;
+          printf("Size=%d, Threads=%d, Active=%d, Time=%f, Solver=PCG, Iterations=%d, Residual=%.2e\n",
+                 M, threads, active, wtime, iterations, plate_residual(w, M, N));
       }
   }
+  arena_destroy(&arena);
   return 0;
 }
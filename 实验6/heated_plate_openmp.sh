@@ -4,20 +4,20 @@ mkdir -p bin
 # Use clang with Homebrew libomp for OpenMP support on macOS
 clang -O3 -Xpreprocessor -fopenmp \
       -I/opt/homebrew/opt/libomp/include \
-      -c heated_plate_openmp.c
+      -c heated_plate_openmp.c ../common/matrix_arena.c
 if [ $? -ne 0 ]; then
   echo "Compile error."
   exit
 fi
 #
 clang -O3 -Xpreprocessor -fopenmp \
-      heated_plate_openmp.o \
+      heated_plate_openmp.o matrix_arena.o \
       -L/opt/homebrew/opt/libomp/lib -lomp -lm -o heated_plate_openmp.out
 if [ $? -ne 0 ]; then
   echo "Load error."
   exit
 fi
-rm heated_plate_openmp.o
+rm heated_plate_openmp.o matrix_arena.o
 mv heated_plate_openmp.out bin/heated_plate_openmp
 echo "===== Comparing OpenMP schedules ====="
 for sched in static dynamic guided; do
@@ -31,7 +31,7 @@ done
 # -------------------------------------------------------------------
 echo "===== Building Pthreads executable ====="
 # link with parallel_for implementation
-clang -O3 -pthread heated_plate_pthreads.c parallel_for.c -lm -o heated_plate_pthreads.out
+clang -O3 -pthread heated_plate_pthreads.c parallel_for.c ../common/thread_affinity.c ../common/matrix_arena.c ../common/autotune.c ../common/trace.c -lm -o heated_plate_pthreads.out
 if [ $? -ne 0 ]; then
   echo "Pthreads compile error."
   exit
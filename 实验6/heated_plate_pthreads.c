@@ -5,6 +5,10 @@
 # include <sys/time.h>
 
 #include "parallel_for.h"
+#include "../common/trace.h"
+#include "../common/matrix_arena.h"
+#include "../common/tlb_counter.h"
+#include "../common/autotune.h"
 
 typedef struct {
   int N;
@@ -27,6 +31,194 @@ void update_point(int idx, void *arg) {
               pa->old_grid[i * N + j + 1]);
 }
 
+/* top and bottom rows 100, left and right columns 0, interior 0 */
+static void plate_init(double *grid, int N) {
+  memset(grid, 0, N * N * sizeof(double));
+  for (int i = 0; i < N; i++) {
+    grid[i] = 100.0;
+    grid[(N-1)*N + i] = 100.0;
+    grid[i*N] = 0.0;
+    grid[i*N + N - 1] = 0.0;
+  }
+}
+
+/* max over the interior of |N + S + W + E - 4 * centre|: zero for the exact solution */
+static double plate_residual(const double *g, int N) {
+  double res = 0.0;
+  for (int i = 1; i < N - 1; i++)
+    for (int j = 1; j < N - 1; j++) {
+      double d = fabs(g[(i-1)*N + j] + g[(i+1)*N + j] + g[i*N + j - 1] + g[i*N + j + 1] - 4.0 * g[i*N + j]);
+      if (d > res) res = d;
+    }
+  return res;
+}
+
+/* Preconditioned conjugate gradient for the same Laplace problem: the unknowns
+   are the interior points, the boundary acts as the right-hand side, and A is
+   the matrix-free 5-point operator 4u - (N + S + W + E). The preconditioner is
+   one symmetric red-black Gauss-Seidel sweep (red z = r/4, black, red again).
+   parallel_for runs over interior rows; every pass that produces the operands
+   of a dot product also writes row i's share to part[i], summed serially in
+   O(N) afterwards (same order for any thread count). One iteration is five
+   passes: q = A p with p.q | w, r update with r.r and red z | black z with r.z |
+   red z with r.z | p = z + b p. */
+#define CG_TOL 1e-8   /* stop when ||r||_2 <= CG_TOL * ||r0||_2 */
+
+typedef struct {
+  int N;
+  double *w, *r, *z, *p, *q, *part;
+  double a, b;
+} CgArgs;
+
+static double cg_sum(const CgArgs *cg) {
+  double s = 0.0;
+  for (int i = 1; i < cg->N - 1; i++) s += cg->part[i];
+  return s;
+}
+
+/* r = b - A w (the 5-point Laplacian of w), r.r, red z = r/4 */
+void cg_init_row(int i, void *arg) {
+  CgArgs *cg = (CgArgs *)arg;
+  int N = cg->N;
+  const double *w = cg->w;
+  double s = 0.0;
+  for (int j = 1; j < N - 1; j++) {
+    int k = i * N + j;
+    double v = w[k - N] + w[k + N] + w[k - 1] + w[k + 1] - 4.0 * w[k];
+    cg->r[k] = v;
+    s += v * v;
+    if (((i + j) & 1) == 0) cg->z[k] = 0.25 * v;
+  }
+  cg->part[i] = s;
+}
+
+/* black points of the preconditioner, r.z */
+void cg_black_row(int i, void *arg) {
+  CgArgs *cg = (CgArgs *)arg;
+  int N = cg->N;
+  double *z = cg->z;
+  double s = 0.0;
+  for (int j = 1 + (i & 1); j < N - 1; j += 2) {
+    int k = i * N + j;
+    double v = 0.25 * (cg->r[k] + z[k - N] + z[k + N] + z[k - 1] + z[k + 1]);
+    z[k] = v;
+    s += cg->r[k] * v;
+  }
+  cg->part[i] = s;
+}
+
+/* red points again from their (final) black neighbours, r.z */
+void cg_red_row(int i, void *arg) {
+  CgArgs *cg = (CgArgs *)arg;
+  int N = cg->N;
+  double *z = cg->z;
+  double s = 0.0;
+  for (int j = 1 + ((i + 1) & 1); j < N - 1; j += 2) {
+    int k = i * N + j;
+    double v = z[k] + 0.25 * (z[k - N] + z[k + N] + z[k - 1] + z[k + 1]);
+    z[k] = v;
+    s += cg->r[k] * v;
+  }
+  cg->part[i] += s;
+}
+
+/* p = z + b p */
+void cg_direction_row(int i, void *arg) {
+  CgArgs *cg = (CgArgs *)arg;
+  int N = cg->N;
+  for (int j = 1; j < N - 1; j++)
+    cg->p[i * N + j] = cg->z[i * N + j] + cg->b * cg->p[i * N + j];
+}
+
+/* q = A p, p.q */
+void cg_apply_row(int i, void *arg) {
+  CgArgs *cg = (CgArgs *)arg;
+  int N = cg->N;
+  const double *p = cg->p;
+  double s = 0.0;
+  for (int j = 1; j < N - 1; j++) {
+    int k = i * N + j;
+    double v = 4.0 * p[k] - p[k - N] - p[k + N] - p[k - 1] - p[k + 1];
+    cg->q[k] = v;
+    s += p[k] * v;
+  }
+  cg->part[i] = s;
+}
+
+/* w += a p, r -= a q, r.r, red z = r/4 */
+void cg_update_row(int i, void *arg) {
+  CgArgs *cg = (CgArgs *)arg;
+  int N = cg->N;
+  double s = 0.0;
+  for (int j = 1; j < N - 1; j++) {
+    int k = i * N + j;
+    cg->w[k] += cg->a * cg->p[k];
+    double v = cg->r[k] - cg->a * cg->q[k];
+    cg->r[k] = v;
+    s += v * v;
+    if (((i + j) & 1) == 0) cg->z[k] = 0.25 * v;
+  }
+  cg->part[i] = s;
+}
+
+/* solves in place on w; returns the iteration count, *active_avg the mean active threads */
+static int plate_pcg(CgArgs *cg, int num_threads, double *active_avg) {
+  int N = cg->N;
+  long long active_sum = 0, passes = 0;
+  memset(cg->r, 0, N * N * sizeof(double));
+  memset(cg->z, 0, N * N * sizeof(double));
+  memset(cg->p, 0, N * N * sizeof(double));
+  memset(cg->q, 0, N * N * sizeof(double));
+#define CG_PASS(fn) do { active_sum += parallel_for_adaptive(1, N - 1, 1, fn, cg, num_threads); \
+                         passes++; } while (0)
+  CG_PASS(cg_init_row);
+  double rr = cg_sum(cg), rz = 0.0;
+  const double stop = CG_TOL * sqrt(rr);
+  int iterations = 0;
+  for (;;) {
+    CG_PASS(cg_black_row);
+    CG_PASS(cg_red_row);
+    double rz_new = cg_sum(cg);
+    if (sqrt(rr) <= stop || rz_new == 0.0) break;
+    cg->b = iterations == 0 ? 0.0 : rz_new / rz;
+    rz = rz_new;
+    CG_PASS(cg_direction_row);
+    CG_PASS(cg_apply_row);
+    cg->a = rz / cg_sum(cg);
+    CG_PASS(cg_update_row);
+    rr = cg_sum(cg);
+    iterations++;
+  }
+#undef CG_PASS
+  *active_avg = (double)active_sum / passes;
+  return iterations;
+}
+
+/* parallel_for worker t first-touches part t of the arena */
+typedef struct {
+  mat_arena_t *arena;
+  int parts;
+} TouchArgs;
+
+void touch_part(int part, void *arg) {
+  TouchArgs *ta = (TouchArgs *)arg;
+  arena_touch(ta->arena, part, ta->parts);
+}
+
+/* auto-tuning: time a fixed number of stencil sweeps with a candidate thread count as the
+   upper bound of parallel_for_adaptive, the same call the Jacobi solve makes */
+#define TUNE_SWEEPS 20
+
+static double plate_measure(const at_config_t *cfg, void *arg) {
+  PlateArgs *pa = (PlateArgs *)arg;
+  struct timeval start, end;
+  gettimeofday(&start, NULL);
+  for (int it = 0; it < TUNE_SWEEPS; ++it)
+    parallel_for_adaptive(0, pa->N * pa->N, 1, update_point, pa, cfg->v[0]);
+  gettimeofday(&end, NULL);
+  return (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
+}
+
 int main ( int argc, char *argv[] );
 
 /******************************************************************************/
@@ -37,58 +229,81 @@ int main ( int argc, char *argv[] )
   int num_options = sizeof(thread_counts) / sizeof(thread_counts[0]);
   int grid_sizes[] = {64, 128, 256, 512, 1024};
   int num_sizes = sizeof(grid_sizes) / sizeof(grid_sizes[0]);
+  int max_N = grid_sizes[num_sizes - 1];
+  int max_threads = thread_counts[num_options - 1];
+  trace_init(0);
+
+  /* both grids and the PCG vectors for every case come from one arena sized for
+     the largest grid, first touched in parallel by the parallel_for workers */
+  mat_arena_t arena;
+  if (arena_init(&arena, 6 * (max_N * max_N * sizeof(double) + ARENA_ALIGN)
+                         + max_N * sizeof(double) + ARENA_ALIGN,
+                 arena_flags_from_env()) != 0) {
+    printf("Memory allocation failed\n");
+    return 1;
+  }
+  TouchArgs touch = { &arena, max_threads };
+  parallel_for(0, max_threads, 1, touch_part, &touch, max_threads);
+  printf("Pages=%s\n", arena_backing_name(&arena));
+
+  /* candidate thread counts for the tuner; the first one is the starting point */
+  int tune_threads[] = {16, 8, 4, 2, 1};
+  at_param_t tune_params[] = { { "threads", tune_threads, 5 } };
 
   for (int s = 0; s < num_sizes; ++s) {
     int N = grid_sizes[s];
 
-    for (int t = 0; t < num_options; ++t) {
-      int num_threads = thread_counts[t];
+    /* best thread count for this grid on this CPU: read from the tuning cache,
+       or found now with short fixed-length runs and stored for next time;
+       solved once more with it after the fixed thread counts */
+    at_config_t tuned;
+    {
+      arena_reset(&arena);
+      double *g0 = arena_alloc(&arena, N * N * sizeof(double));
+      double *g1 = arena_alloc(&arena, N * N * sizeof(double));
+      memset(g0, 0, N * N * sizeof(double));
+      memset(g1, 0, N * N * sizeof(double));
+      PlateArgs targs = { N, g0, g1 };
+      int from = at_tune("heated_plate_pthreads_adaptive", N, tune_params, 1, plate_measure, &targs, &tuned);
+      printf("GridSize=%d, Tuned threads=%d (%s)\n", N, tuned.v[0],
+             from == 1 ? "cache" : from == 0 ? "search" : "default");
+    }
+
+    for (int t = 0; t <= num_options; ++t) {
+      int num_threads = t < num_options ? thread_counts[t] : tuned.v[0];
+      const char *config = t < num_options ? "fixed" : "tuned";
 
-      double *old_grid = malloc(N * N * sizeof(double));
-      double *new_grid = malloc(N * N * sizeof(double));
+      arena_reset(&arena);
+      double *old_grid = arena_alloc(&arena, N * N * sizeof(double));
+      double *new_grid = arena_alloc(&arena, N * N * sizeof(double));
 
       if (old_grid == NULL || new_grid == NULL) {
         printf("Memory allocation failed\n");
         return 1;
       }
 
-      // Initialize grids
-      memset(old_grid, 0, N * N * sizeof(double));
-      memset(new_grid, 0, N * N * sizeof(double));
-
-      // Set boundary values
-      for (int i = 0; i < N; i++) {
-        old_grid[i] = 100.0;
-        new_grid[i] = 100.0;
-        old_grid[(N-1)*N + i] = 100.0;
-        new_grid[(N-1)*N + i] = 100.0;
-        old_grid[i*N] = 0.0;
-        new_grid[i*N] = 0.0;
-        old_grid[i*N + N - 1] = 0.0;
-        new_grid[i*N + N - 1] = 0.0;
-      }
-
-      // Initialize interior points to 0
-      for (int i = 1; i < N - 1; i++) {
-        for (int j = 1; j < N - 1; j++) {
-          old_grid[i*N + j] = 0.0;
-          new_grid[i*N + j] = 0.0;
-        }
-      }
+      // Initialize grids: boundary values, interior 0
+      plate_init(old_grid, N);
+      plate_init(new_grid, N);
 
       struct timeval start, end;
+      tlb_counter_t tlb;
+      tlb_counter_start(&tlb);
       gettimeofday(&start, NULL);
 
       double epsilon = 0.01;
       double diff;
       int iterations = 0;
+      long long active_sum = 0;
 
       do {
-        /* parallel stencil update */
+        /* parallel stencil update; num_threads is an upper bound, small grids
+           run on fewer threads (or serially) when fork/join would dominate */
         PlateArgs args = { N, old_grid, new_grid };
-        parallel_for(0, N * N, 1, update_point, &args, num_threads);
+        active_sum += parallel_for_adaptive(0, N * N, 1, update_point, &args, num_threads);
 
         /* sequential reduction to obtain max‑difference */
+        double trace_t0 = trace_begin();
         diff = 0.0;
         for (int i = 1; i < N - 1; i++) {
           for (int j = 1; j < N - 1; j++) {
@@ -96,6 +311,7 @@ int main ( int argc, char *argv[] )
             if (delta > diff) diff = delta;
           }
         }
+        trace_end_n("reduce", trace_t0, iterations);
 
         /* swap grids */
         double *temp = old_grid;
@@ -106,18 +322,43 @@ int main ( int argc, char *argv[] )
 
       gettimeofday(&end, NULL);
       double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
+      long long tlb_misses = tlb_counter_stop(&tlb);
 
       double checksum = 0.0;
       for (int i = 0; i < N * N; i++) {
         checksum += old_grid[i];
       }
 
-      printf("GridSize=%d, Threads=%d, Time=%.6f s, Checksum=%f\n", N, num_threads, elapsed, checksum);
+      printf("GridSize=%d, Threads=%d, Config=%s, Active=%.1f, Time=%.6f s, Checksum=%f, dTLB misses=%lld, "
+             "Solver=Jacobi, Iterations=%d, Residual=%.2e\n",
+             N, num_threads, config, (double)active_sum / iterations, elapsed, checksum, tlb_misses,
+             iterations, plate_residual(old_grid, N));
 
-      free(old_grid);
-      free(new_grid);
+      // Same problem and initial guess solved by PCG on old_grid
+      CgArgs cg = { N, old_grid,
+                    arena_alloc(&arena, N * N * sizeof(double)), arena_alloc(&arena, N * N * sizeof(double)),
+                    arena_alloc(&arena, N * N * sizeof(double)), arena_alloc(&arena, N * N * sizeof(double)),
+                    arena_alloc(&arena, N * sizeof(double)), 0.0, 0.0 };
+      plate_init(old_grid, N);
+      double active_avg;
+      tlb_counter_start(&tlb);
+      gettimeofday(&start, NULL);
+      iterations = plate_pcg(&cg, num_threads, &active_avg);
+      gettimeofday(&end, NULL);
+      elapsed = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
+      tlb_misses = tlb_counter_stop(&tlb);
+      checksum = 0.0;
+      for (int i = 0; i < N * N; i++) {
+        checksum += old_grid[i];
+      }
+      printf("GridSize=%d, Threads=%d, Config=%s, Active=%.1f, Time=%.6f s, Checksum=%f, dTLB misses=%lld, "
+             "Solver=PCG, Iterations=%d, Residual=%.2e\n",
+             N, num_threads, config, active_avg, elapsed, checksum, tlb_misses,
+             iterations, plate_residual(old_grid, N));
     }
   }
+  arena_destroy(&arena);
+  trace_dump();
 
   return 0;
 }
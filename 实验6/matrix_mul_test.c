@@ -2,59 +2,141 @@
 #include <stdlib.h>
 #include <time.h>
 #include "parallel_for.h"
+#include "../common/trace.h"
+#include "../common/counter_rng.h"
+#include "../common/matrix_arena.h"
+#include "../common/tlb_counter.h"
+#include "../common/freivalds.h"
+#include "../common/gemm.h"
 
-// functor 参数结构
-typedef struct {
-    int M, N, P;
-    float *A, *B, *C;
-} MatMulArgs;
-
-// functor：对单个元素 (row, col) 进行乘加
+// functor：计算统一为行主序后 C 的单个元素 (row, col) = alpha * op(A) 的行 · op(B) 的列 + beta * C
 void matmul_functor(int idx, void *arg) {
-    MatMulArgs *a = (MatMulArgs*)arg;
-    int row = idx / a->P;
-    int col = idx % a->P;
+    const gemm_f32_t *g = (const gemm_f32_t*)arg;
+    int row = idx / g->N;
+    int col = idx % g->N;
+    const float *a = g->A + (size_t)row * g->a_rs;
+    const float *b = g->B + (size_t)col * g->b_cs;
     float sum = 0;
-    for (int k = 0; k < a->N; ++k) {
-        sum += a->A[row * a->N + k] * a->B[k * a->P + col];
+    for (int k = 0; k < g->K; ++k) {
+        sum += a[(size_t)k * g->a_cs] * b[(size_t)k * g->b_rs];
     }
-    a->C[row * a->P + col] = sum;
+    float *c = g->C + (size_t)row * g->ldc + col;
+    *c = g->alpha * sum + (g->beta == 0.0f ? 0.0f : g->beta * *c);   // beta = 0 时不读取 C
+}
+
+// 与 cblas_sgemm 参数相同的完整 GEMM，C 的每个元素为 parallel_for 的一次迭代；参数非法返回 -1
+int parallel_sgemm(gemm_order_t order, gemm_trans_t ta, gemm_trans_t tb, int M, int N, int K,
+                   float alpha, const float *A, size_t lda, const float *B, size_t ldb,
+                   float beta, float *C, size_t ldc, int num_threads) {
+    gemm_f32_t g;
+    if (gemm_f32_setup(&g, order, ta, tb, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc) != 0)
+        return -1;
+    parallel_for(0, g.M * g.N, 1, matmul_functor, &g, num_threads);
+    return 0;
+}
+
+// GEMM 接口自检的被测核：4 个线程
+static void selftest_sgemm(gemm_order_t order, gemm_trans_t ta, gemm_trans_t tb, int M, int N, int K,
+                           float alpha, const float *A, size_t lda, const float *B, size_t ldb,
+                           float beta, float *C, size_t ldc, void *ctx) {
+    (void)ctx;
+    parallel_sgemm(order, ta, tb, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc, 4);
+}
+
+// functor 参数结构：按行并行填充随机矩阵
+typedef struct {
+    int cols;
+    float *mat;
+    uint64_t key;
+} FillArgs;
+
+// functor：用计数器随机数填充第 row 行，结果与线程数无关
+void fill_row_functor(int row, void *arg) {
+    FillArgs *f = (FillArgs*)arg;
+    long long begin = (long long)row * f->cols;
+    crng_fill_uniform_f(f->mat + begin, begin, begin + f->cols, f->key, 0.0f, 1.0f);
+}
+
+// functor 参数结构：parallel_for 的第 t 个工作线程首次访问内存池的第 t 段
+typedef struct {
+    mat_arena_t *arena;
+    int parts;
+} TouchArgs;
+
+void touch_functor(int part, void *arg) {
+    TouchArgs *t = (TouchArgs*)arg;
+    arena_touch(t->arena, part, t->parts);
 }
 
 int main() {
+    uint64_t seed = crng_seed_from_env(CRNG_DEFAULT_SEED);
+    int fv_trials = fv_trials_for(fv_false_positive_from_env());
+    trace_init(0);
+
     int sizes[] = {128, 256, 512, 1024, 2048};
     int thread_counts[] = {1, 2, 4, 8, 16};
+    int max_size = sizes[sizeof(sizes)/sizeof(sizes[0]) - 1];
+    int max_threads = thread_counts[sizeof(thread_counts)/sizeof(thread_counts[0]) - 1];
+
+    // 按最大规模一次性映射 A、B、C，由 parallel_for 工作线程并行首次访问，所有用例复用
+    mat_arena_t arena;
+    if (arena_init(&arena, 3 * (sizeof(float) * max_size * max_size + ARENA_ALIGN),
+                   arena_flags_from_env()) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return 1;
+    }
+    TouchArgs touch = {&arena, max_threads};
+    parallel_for(0, max_threads, 1, touch_functor, &touch, max_threads);
+    printf("Pages=%s\n", arena_backing_name(&arena));
+
+    // 行/列主序、转置、跨度与 alpha / beta 的各种组合与逐元素参考比较
+    double gemm_err = gemm_selftest_f32(selftest_sgemm, NULL);
+    printf("GEMM self-test: max rel. error=%.2e, %s\n", gemm_err,
+           (gemm_err >= 0.0 && gemm_err < 1e-5) ? "PASS" : "FAIL");
 
     for (int si = 0; si < sizeof(sizes)/sizeof(sizes[0]); ++si) {
         int size = sizes[si];
         for (int ti = 0; ti < sizeof(thread_counts)/sizeof(thread_counts[0]); ++ti) {
             int threads = thread_counts[ti];
 
-            float *A = malloc(sizeof(float) * size * size);
-            float *B = malloc(sizeof(float) * size * size);
-            float *C = malloc(sizeof(float) * size * size);
+            arena_reset(&arena);
+            float *A = arena_alloc(&arena, sizeof(float) * size * size);
+            float *B = arena_alloc(&arena, sizeof(float) * size * size);
+            float *C = arena_alloc(&arena, sizeof(float) * size * size);
 
-            for (int i = 0; i < size * size; ++i) A[i] = (float)(rand()) / RAND_MAX;
-            for (int i = 0; i < size * size; ++i) B[i] = (float)(rand()) / RAND_MAX;
-
-            MatMulArgs args = {size, size, size, A, B, C};
-            int total = size * size;
+            FillArgs fillA = {size, A, crng_key(seed, 0)};
+            FillArgs fillB = {size, B, crng_key(seed, 1)};
+            double trace_t0 = trace_begin();
+            parallel_for(0, size, 1, fill_row_functor, &fillA, threads);
+            parallel_for(0, size, 1, fill_row_functor, &fillB, threads);
+            trace_end_n("fill", trace_t0, size);
 
             struct timespec t0, t1;
+            tlb_counter_t tlb;
+            tlb_counter_start(&tlb);
             clock_gettime(CLOCK_MONOTONIC, &t0);
+            trace_t0 = trace_begin();
 
-            parallel_for(0, total, 1, matmul_functor, &args, threads);
+            parallel_sgemm(GEMM_ROW_MAJOR, GEMM_NO_TRANS, GEMM_NO_TRANS, size, size, size,
+                           1.0f, A, size, B, size, 0.0f, C, size, threads);
+            trace_end_n("multiply", trace_t0, size);
 
             clock_gettime(CLOCK_MONOTONIC, &t1);
             double elapsed = (t1.tv_sec - t0.tv_sec)
                            + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
 
-            printf("Size=%d, Threads=%d, Time=%.6f s\n", size, threads, elapsed);
+            long long tlb_misses = tlb_counter_stop(&tlb);
+
+            // Freivalds 随机校验 C = A * B（计时之外，O(n^2)）
+            trace_t0 = trace_begin();
+            double residual = fv_check_rows_f32(A, B, C, size, size, size, fv_trials, seed);
+            trace_end_n("verify", trace_t0, size);
 
-            free(A);
-            free(B);
-            free(C);
+            printf("Size=%d, Threads=%d, Time=%.6f s, dTLB misses=%lld, Check=%s\n", size, threads, elapsed,
+                   tlb_misses, (residual >= 0.0 && residual <= 1.0) ? "PASS" : "FAIL");
         }
     }
+    arena_destroy(&arena);
+    trace_dump();
     return 0;
 }
\ No newline at end of file
@@ -1,7 +1,12 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
 #include "parallel_for.h"
+#include "../common/thread_affinity.h"
+#include "../common/trace.h"
 
 #include <pthread.h>
 
@@ -21,9 +26,15 @@ typedef struct {
    not divisible by num_threads */
 static void *pf_worker(void *p) {
     PFTask *t = (PFTask *)p;
+    affinity_bind_self(t->tid);
+    trace_set_thread(t->tid);
+    double t0 = trace_begin();
+    int items = 0;
     for (int i = t->start + t->tid * t->inc; i < t->end; i += t->inc * t->num_threads) {
         t->functor(i, t->arg);
+        items++;
     }
+    trace_end_n("parallel_for", t0, items);
     return NULL;
 }
 
@@ -32,8 +43,10 @@ void parallel_for(int start, int end, int inc,
                   void *arg, int num_threads)
 {
     if (num_threads <= 1) {               /* fallback to serial */
+        double t0 = trace_begin();
         for (int i = start; i < end; i += inc)
             functor(i, arg);
+        trace_end("parallel_for serial", t0);
         return;
     }
 
@@ -64,4 +77,123 @@ void parallel_for(int start, int end, int inc,
 
     free(threads);
     free(tasks);
-}
\ No newline at end of file
+}
+/* ---------------- adaptive variant ---------------- */
+
+#define PF_PROBE_ITEMS 64      /* items run serially to estimate an unknown functor */
+#define PF_COST_SLOTS  32      /* remembered (functor, arg, item count) per-item costs */
+#define PF_EWMA        0.5     /* weight of the newest measurement */
+
+typedef struct {
+    void (*functor)(int, void *);
+    void *arg;
+    long long items;           /* loop length: the same arg may describe a new problem size */
+    double item_cost;          /* seconds per item */
+} PFCost;
+
+static PFCost pf_costs[PF_COST_SLOTS];
+static int pf_cost_next = 0;
+static double pf_overhead = 0.0;
+static pthread_once_t pf_overhead_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t pf_cost_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static double pf_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void pf_noop(int i, void *arg) {
+    (void)i;
+    (void)arg;
+}
+
+/* fork/join cost per thread: best of a few empty parallel_for calls */
+static void pf_measure_overhead(void) {
+    const int nt = 4;
+    double best = 1e9;
+    for (int r = 0; r < 5; ++r) {
+        double t0 = pf_now();
+        parallel_for(0, nt, 1, pf_noop, NULL, nt);
+        double t = (pf_now() - t0) / nt;
+        if (t < best) best = t;
+    }
+    pf_overhead = best;
+}
+
+double parallel_for_overhead(void) {
+    pthread_once(&pf_overhead_once, pf_measure_overhead);
+    return pf_overhead;
+}
+
+/* slot for (functor, arg, items), NULL if unknown */
+static PFCost *pf_cost_find(void (*functor)(int, void *), void *arg, long long items) {
+    for (int s = 0; s < PF_COST_SLOTS; ++s)
+        if (pf_costs[s].functor == functor && pf_costs[s].arg == arg && pf_costs[s].items == items)
+            return &pf_costs[s];
+    return NULL;
+}
+
+static void pf_cost_update(void (*functor)(int, void *), void *arg, long long items, double item_cost) {
+    pthread_mutex_lock(&pf_cost_lock);
+    PFCost *c = pf_cost_find(functor, arg, items);
+    if (c) {
+        c->item_cost = PF_EWMA * item_cost + (1.0 - PF_EWMA) * c->item_cost;
+    } else {
+        c = &pf_costs[pf_cost_next];
+        pf_cost_next = (pf_cost_next + 1) % PF_COST_SLOTS;
+        *c = (PFCost){ functor, arg, items, item_cost };
+    }
+    pthread_mutex_unlock(&pf_cost_lock);
+}
+
+int parallel_for_adaptive(int start, int end, int inc,
+                          void (*functor)(int, void *),
+                          void *arg, int num_threads)
+{
+    const char *env = getenv("PF_ADAPTIVE");
+    if ((env && strcmp(env, "0") == 0) || inc <= 0) {
+        parallel_for(start, end, inc, functor, arg, num_threads);
+        return num_threads < 1 ? 1 : num_threads;
+    }
+    if (start >= end) return 1;
+
+    const long long total = ((long long)end - start + inc - 1) / inc;
+    pthread_mutex_lock(&pf_cost_lock);
+    PFCost *known = pf_cost_find(functor, arg, total);
+    double item_cost = known ? known->item_cost : -1.0;
+    pthread_mutex_unlock(&pf_cost_lock);
+
+    /* unknown functor: run a few items serially to estimate the per-item cost */
+    if (item_cost < 0.0) {
+        int probe_end = start;
+        double trace_t0 = trace_begin();
+        double t0 = pf_now();
+        for (int k = 0; k < PF_PROBE_ITEMS && probe_end < end; ++k, probe_end += inc)
+            functor(probe_end, arg);
+        int probed = (probe_end - start + inc - 1) / inc;
+        item_cost = (pf_now() - t0) / probed;
+        trace_end_n("parallel_for probe", trace_t0, probed);
+        pf_cost_update(functor, arg, total, item_cost);
+        start = probe_end;
+        if (start >= end) return 1;
+    }
+
+    /* threads beyond the online CPUs only add overhead */
+    int max_threads = num_threads < 1 ? 1 : num_threads;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus > 0 && cpus < max_threads) max_threads = (int)cpus;
+
+    long long items = ((long long)end - start + inc - 1) / inc;
+    double overhead = parallel_for_overhead();
+    int p = pf_choose_threads(items * item_cost, overhead, max_threads);
+
+    double t0 = pf_now();
+    parallel_for(start, end, inc, functor, arg, p);
+    double elapsed = pf_now() - t0;
+
+    /* invert the model to turn the measured time back into total work */
+    double work = (p > 1) ? (elapsed - p * overhead) * p : elapsed;
+    if (work > 0.0) pf_cost_update(functor, arg, total, work / items);
+    return p;
+}
@@ -6,4 +6,38 @@ void parallel_for(int start, int end, int inc,
                   void (*functor)(int, void*),
                   void* arg, int num_threads);
 
-#endif
\ No newline at end of file
+/*
+ * 自适应并行 for：num_threads 为线程数上限（同时不超过在线 CPU 数），
+ * 每次调用按代价模型决定实际启用的线程数，工作量太小时直接串行执行。
+ *   - 每个 (functor, arg, 迭代次数) 的单项耗时由之前调用的实测时间估计（指数滑动平均），
+ *     第一次遇到时先串行执行少量迭代作为探测；同一 arg 换了问题规模时重新探测；
+ *   - 创建并回收一个线程的开销在第一次调用时实测一次。
+ * 环境变量 PF_ADAPTIVE=0 时退化为 parallel_for（严格使用 num_threads 个线程）。
+ * 返回本次调用实际使用的线程数。可被多个线程同时调用：单项耗时缓存与 fork/join 开销为进程级全局状态，
+ * 缓存由互斥锁保护，开销只在第一次调用时测量一次（pthread_once）。
+ */
+int parallel_for_adaptive(int start, int end, int inc,
+                          void (*functor)(int, void*),
+                          void* arg, int num_threads);
+
+// 实测的每个线程 fork/join 开销（秒）
+double parallel_for_overhead(void);
+
+/*
+ * 代价模型：总工作量 work 秒分给 p 个线程，耗时约 work / p + p * overhead_per_thread
+ * （线程由主线程逐个创建和回收，开销随线程数线性增长）。返回 [1, max_threads] 中使其最小的 p。
+ */
+static inline int pf_choose_threads(double work, double overhead_per_thread, int max_threads) {
+    int best = 1;
+    double best_time = work;
+    for (int p = 2; p <= max_threads; ++p) {
+        double t = work / p + p * overhead_per_thread;
+        if (t < best_time) {
+            best_time = t;
+            best = p;
+        }
+    }
+    return best;
+}
+
+#endif